@@ -0,0 +1,57 @@
+#!/bin/bash
+# generate training data on several cores: run one "datagen" process per core,
+# each with its own seed, directory and file, and append their files in seed
+# order to the output file
+#
+# usage: ../scripts/datagen.sh [processes] [games] [nodes] [seed] [file]
+#
+# run from src/ (or set ENGINE to the engine binary). Each process plays
+# 'games' games with seed 'seed' + i, so a run is reproducible for the same
+# number of processes. The summary reports the positions and the throughput
+# measured over the whole run.
+
+error()
+{
+  echo "datagen failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+processes=${1:-`nproc`}
+games=${2:-100}
+nodes=${3:-5000}
+seed=${4:-1}
+file=${5:-geister.bin}
+
+engine=`realpath ${ENGINE:-./stockfish}`
+work=`mktemp -d datagen.XXXXXX`
+
+start=`date +%s%N`
+
+# datagen writes result.txt in the current directory, so each process runs in
+# a directory of its own
+for ((i = 0; i < processes; i++)); do
+  mkdir $work/$i
+  (cd $work/$i && $engine datagen $games $nodes $((seed + i)) part.bin < /dev/null > /dev/null 2> datagen.err) &
+done
+wait
+
+elapsed=$(( (`date +%s%N` - start) / 1000000 + 1 ))
+
+positions=0
+for ((i = 0; i < processes; i++)); do
+  count=`sed -n "s/^Positions      : //p" $work/$i/datagen.err`
+  [ -n "$count" ]
+  positions=$((positions + count))
+  cat $work/$i/part.bin >> $file
+done
+
+rm -rf $work
+
+echo "Processes      : $processes"
+echo "Games          : $((processes * games))"
+echo "Positions      : $positions"
+echo "Total time (ms): $elapsed"
+echo "Positions/sec  : $((1000 * positions / elapsed))"
+echo "Per process    : $((1000 * positions / elapsed / processes))"
+echo "Training data  : $file"
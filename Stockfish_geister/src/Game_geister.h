@@ -2,6 +2,7 @@
 #define GAME_GEISTER_H_INCLUDED
 
 #include <string>
+#include <vector>
 #include "types.h"
 
 //S position.h ɈڐA
@@ -63,6 +64,9 @@ namespace Red {
 	extern bool existRed;
 	extern bool bare;	//oĂ
 
+	//ԓx̏d݂, Ԃƌ߂臒l (evaluate.cpp  TUNE Œ)
+	extern int weightOikake, weightOikakePinti, weightHairi, redThreshold;
+
 
 	//JnɌĂяo
 	void init();
@@ -78,5 +82,8 @@ namespace Red {
 	//͍ő̂gĂȂ̂ŉ
 	int listUpRed(int posY[], int posX[], int X);
 	Square picUpRed(int X);
+
+	//PIMCp. ̋̐F̉ k TvO
+	std::vector<std::string> samples(const Position& pos, int k);
 }
 #endif
\ No newline at end of file
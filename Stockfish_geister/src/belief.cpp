@@ -0,0 +1,298 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "belief.h"
+#include "misc.h"
+#include "position.h"
+#include "Game_geister.h"
+
+namespace Belief {
+  State state;
+}
+
+namespace {
+
+  int Masks[Belief::AssignNum];	//蓖 i ̐Ԃ̋̏W
+  Belief::Likelihood likelihood = Belief::heuristic_likelihood;
+
+  //oɂ̂ɒEoȂ̖ޓx, ǂĂԂ̂Ƃ̖ޓx ( 1)
+  const double MissedEscape = 0.05;
+  const double ChaseRed = 1.5;
+  const double ChaseRedPinch = 1.1;	//̐Ԃ 1 ̎͑킯킩sȂ̂Ŏキ
+
+  const int dy[4] = { -1, 0, 1, 0 };
+  const int dx[4] = { 0, 1, 0, -1 };
+
+  //(y, x) ׂ̗Ɏ̋ (R, B) 邩
+  bool nextToUs(const char board[6][6], int y, int x) {
+    for (int i = 0; i < 4; i++) {
+      int ny = y + dy[i], nx = x + dx[i];
+      if (0 <= ny && ny < 6 && 0 <= nx && nx < 6 && (board[ny][nx] == 'R' || board[ny][nx] == 'B'))
+        return true;
+    }
+    return false;
+  }
+
+  //ӊmƃ}XƂ̕\蒼
+  void update_marginals() {
+    Belief::State& st = Belief::state;
+
+    for (int p = 0; p < Belief::PieceNum; p++) {
+      st.redProb[p] = 0;
+      for (int i = 0; i < Belief::AssignNum; i++)
+        if (Masks[i] >> p & 1)
+          st.redProb[p] += st.prob[i];
+    }
+
+    std::fill(st.squareRed, st.squareRed + SQUARE_NB, 0.0);
+    for (int p = 0; p < Belief::PieceNum; p++)
+      if (st.square[p] != SQ_NONE)
+        st.squareRed[st.square[p]] = st.redProb[p];
+  }
+
+  //v 1 ɂȂ悤. S 0 ɂȂ (fƖ) false
+  bool normalize() {
+    double sum = 0;
+    for (double p : Belief::state.prob)
+      sum += p;
+
+    if (sum <= 0)
+      return false;
+
+    for (double& p : Belief::state.prob)
+      p /= sum;
+    return true;
+  }
+}
+
+//̖ޓxf.
+//EEoɂ, ȂEoďĂ͂Ȃ̂Ő (weightHairi Ɠl)
+//E̋痣ꂽƂ납ׂɊĂ (ǂ) ͐Ԃۂ (weightOikake)
+double Belief::heuristic_likelihood(const Observation& obs, int reds) {
+  double l = 1.0;
+
+  for (int x : { 0, 5 }) {
+    int p = obs.pieceAt[make_square(File(x), RANK_6)];
+    if (p >= 0 && obs.before[5][x] == 'u' && !(reds >> p & 1))
+      l *= MissedEscape;
+  }
+
+  int fy = rank_of(obs.from), fx = file_of(obs.from);
+  int ty = rank_of(obs.to), tx = file_of(obs.to);
+  int myRed = 0;
+  for (int y = 0; y < 6; y++)
+    for (int x = 0; x < 6; x++)
+      myRed += obs.before[y][x] == 'R';
+
+  bool capture = obs.before[ty][tx] == 'R' || obs.before[ty][tx] == 'B';
+  if (!capture && !nextToUs(obs.before, fy, fx) && nextToUs(obs.before, ty, tx) && (reds >> obs.piece & 1))
+    l *= myRed == 1 ? ChaseRedPinch : ChaseRed;
+
+  return l;
+}
+
+void Belief::init() {
+  int n = 0;
+  for (int m = 0; m < (1 << PieceNum); m++)
+    if (popcount(Bitboard(m)) == 4)
+      Masks[n++] = m;
+
+  for (int i = 0; i < AssignNum; i++)
+    state.prob[i] = 1.0 / AssignNum;
+
+  std::fill(state.square, state.square + PieceNum, SQ_NONE);
+  std::fill(state.pieceAt, state.pieceAt + SQUARE_NB, int8_t(-1));
+  state.started = false;
+  update_marginals();
+}
+
+void Belief::set_likelihood(Likelihood f) {
+  likelihood = f;
+}
+
+Square Belief::likely_red(double threshold) {
+  Square best = SQ_NONE;
+  for (int p = 0; p < PieceNum; p++)
+    if (state.square[p] != SQ_NONE && state.redProb[p] >= threshold) {
+      threshold = state.redProb[p];
+      best = state.square[p];
+    }
+  return best;
+}
+
+int Belief::assignment(int i) {
+  return Masks[i];
+}
+
+void Belief::update(const std::string& msg, const char (*before)[6]) {
+  const int baius = 4;
+  Square now[PieceNum];
+  int known = 0, knownRed = 0;	//F킩 () ̏W, ̂
+
+  for (int p = 0; p < PieceNum; p++) {
+    size_t k = baius + 3 * (p + 8);
+    int x = msg[k] - '0', y = msg[k + 1] - '0';
+    char type = msg[k + 2];
+
+    now[p] = 0 <= x && x < 6 && 0 <= y && y < 6 ? make_square(File(x), Rank(y)) : SQ_NONE;
+    if (now[p] == SQ_NONE && (type == 'r' || type == 'b')) {
+      known |= 1 << p;
+      if (type == 'r')
+        knownRed |= 1 << p;
+    }
+  }
+
+  // (Տŏꏊς) ̎ϑƂăfɓn
+  if (state.started && before) {
+    Observation obs;
+    obs.piece = -1;
+    std::memcpy(obs.before, before, sizeof(obs.before));
+    std::memcpy(obs.pieceAt, state.pieceAt, sizeof(obs.pieceAt));
+
+    for (int p = 0; p < PieceNum; p++)
+      if (state.square[p] != SQ_NONE && now[p] != SQ_NONE && now[p] != state.square[p]) {
+        obs.piece = p, obs.from = state.square[p], obs.to = now[p];
+        break;
+      }
+
+    if (obs.piece >= 0) {
+      double saved[AssignNum];
+      std::memcpy(saved, state.prob, sizeof(saved));
+
+      for (int i = 0; i < AssignNum; i++)
+        if (state.prob[i] > 0)
+          state.prob[i] *= likelihood(obs, Masks[i]);
+
+      //fł͋N肦Ȃ肾, ̎͌ȂƂɂ
+      if (!normalize())
+        std::memcpy(state.prob, saved, sizeof(saved));
+    }
+  }
+
+  //̐FƍȂ蓖Ă
+  for (int i = 0; i < AssignNum; i++)
+    if ((Masks[i] & known) != knownRed)
+      state.prob[i] = 0;
+
+  //S (fOĂ) , ̐Fƍ̑Slɂ蒼
+  if (!normalize()) {
+    for (int i = 0; i < AssignNum; i++)
+      state.prob[i] = (Masks[i] & known) == knownRed;
+    normalize();
+  }
+
+  std::fill(state.pieceAt, state.pieceAt + SQUARE_NB, int8_t(-1));
+  for (int p = 0; p < PieceNum; p++) {
+    state.square[p] = now[p];
+    if (now[p] != SQ_NONE)
+      state.pieceAt[now[p]] = int8_t(p);
+  }
+
+  state.started = true;
+  update_marginals();
+}
+
+std::vector<std::string> Belief::samples(const Position& pos, int k) {
+  std::vector<std::string> result;
+  std::string fen = pos.fen();
+  std::vector<std::pair<size_t, int>> pieces;	//fen ̒̐F̈ʒuƋ
+  int onBoard = 0, fixedRed = 0;
+
+  if (!state.started)
+    return result;
+
+  for (size_t i = 4; i + 2 < fen.size() && fen[i] != ' '; i += 3) {
+    char c = fen[i + 2];
+    if (c != 'u' && c != 'r')
+      continue;
+    int p = state.pieceAt[make_square(File(fen[i] - '0'), Rank(fen[i + 1] - '0'))];
+    if (p < 0)
+      return result;
+    pieces.emplace_back(i + 2, p);
+    onBoard |= 1 << p;
+    if (c == 'r')
+      fixedRed |= 1 << p;
+  }
+
+  //MO̕ɂȂΕʂ̔Ֆ
+  if (popcount(Bitboard(onBoard)) != std::count_if(state.square, state.square + PieceNum,
+                                                    [](Square sq) { return sq != SQ_NONE; }))
+    return result;
+
+  //ɐԂƌ߂ (B_RED) Ԃ̊蓖Ăŕz
+  double cdf[AssignNum], sum = 0;
+  int support = 0;
+  for (int i = 0; i < AssignNum; i++) {
+    if ((Masks[i] & fixedRed) == fixedRed && state.prob[i] > 0)
+      sum += state.prob[i], support++;
+    cdf[i] = sum;
+  }
+
+  if (sum <= 0)
+    return result;
+
+  //S̉ɂȂȂ 1 ŏ\
+  if (support == 1)
+    k = 1;
+
+  PRNG rng(pos.key() | 1);
+
+  for (int n = 0; n < k; n++) {
+    double t = sum * (rng.rand<uint64_t>() >> 11) * (1.0 / (1ULL << 53));
+    int i = int(std::upper_bound(cdf, cdf + AssignNum, t) - cdf);
+    i = std::min(i, AssignNum - 1);
+
+    std::string s = fen;
+    for (auto& pc : pieces)
+      s[pc.first] = (Masks[i] >> pc.second & 1) ? 'r' : 'u';
+    result.push_back(s);
+  }
+  return result;
+}
+
+void Belief::set_red_probs(Position& pos) {
+  float prob[SQUARE_NB] = {};
+  const Square* sq = pos.squares<PURPLE>(BLACK);
+  int n = pos.count<PURPLE>(BLACK);
+
+  //MŐƔՖʂ̎̋ΈɑΉ邩
+  bool tracked = state.started && pos.count<RED>(BLACK) == 0
+              && n == std::count_if(state.square, state.square + PieceNum,
+                                    [](Square s) { return s != SQ_NONE; });
+  for (int i = 0; i < n && tracked; i++)
+    tracked = state.pieceAt[sq[i]] >= 0;
+
+  //ՖʂƍȂ (bench Ȃ) ł, ԂƐ 1 ͎c
+  int reds = std::min(std::max(Game_::rNum - pos.count<RED>(BLACK), 1), std::max(n - 1, 0));
+
+  if (tracked) {
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+      sum += prob[sq[i]] = float(state.squareRed[sq[i]]);
+    reds = int(sum + 0.5);
+  }
+  else {
+    for (int i = 0; i < n; i++)
+      prob[sq[i]] = float(reds) / n;
+  }
+
+  pos.set_red_probs(prob, reds, n - reds);
+}
@@ -0,0 +1,91 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BELIEF_H_INCLUDED
+#define BELIEF_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+class Position;
+
+//̋ a-h ̐FɂĂ̐MO (m)
+// 4 ̊蓖Ă C(8,4) = 70 ʂ肵Ȃ̂, S̊m
+//̎Ǝ̐F邽тɃxCYXV.
+namespace Belief
+{
+
+	const int PieceNum = 8;		//̋ a-h
+	const int AssignNum = 70;	// 4 ̊蓖Ă̐
+
+	// 1 ̊ϑ
+	struct Observation {
+		int piece;							// (0-7 = a-h)
+		Square from, to;
+		char before[6][6];					//O̔Ֆ (R, B, u, '.') y=5̑
+		int8_t pieceAt[SQUARE_NB];		//OɊe}Xɂ̋ (Ȃ -1)
+	};
+
+	//ޓxf: Ԃ̋̏W reds (bit i =  i ) ̂Ƃ, obs ̎肪wޓx.
+	//萔{͋CɂȂĂ悢.
+	typedef double (*Likelihood)(const Observation& obs, int reds);
+
+	//Red::myTurn ̐ԓxƓl̊̃f
+	double heuristic_likelihood(const Observation& obs, int reds);
+
+	struct State {
+		double prob[AssignNum];			//蓖ĂƂ̊m
+		double redProb[PieceNum];			//Ƃ̐Ԃ̎ӊm
+		double squareRed[SQUARE_NB];		//}Xɂ鑊̋Ԃ̊m (Ȃ 0)
+		int8_t pieceAt[SQUARE_NB];		//}Xɂ鑊̋ (Ȃ -1)
+		Square square[PieceNum];			//̈ʒu (ՏɂȂ SQ_NONE)
+		bool started;
+	};
+
+	extern State state;
+
+	//JnɌĂяo (Red::init )
+	void init();
+
+	//ޓxf̍ւ
+	void set_likelihood(Likelihood f);
+
+	//̎Ԃ̔Ֆ msg (MOV?...) 󂯎邽тɌĂяo.
+	//before ͑肪O̔Ֆ (ŏ̎Ԃ nullptr)
+	void update(const std::string& msg, const char (*before)[6]);
+
+	//Ԃ̎ӊm. O(1)
+	inline double red_prob(int piece) { return state.redProb[piece]; }
+	inline double red_prob(Square s) { return state.squareRed[s]; }
+
+	//Ԃ̊m threshold ȏ̋̂ԐԂۂ̃}X (Ȃ SQ_NONE)
+	Square likely_red(double threshold);
+
+	//蓖 i ŐԂɂȂ̏W (bit i =  i)
+	int assignment(int i);
+
+	//pos ̑̋MŐ̈ʒuƈvĂ, 㕪zF̉
+	//k  Position::set() ɓn镶ŕԂ. vȂ΋.
+	std::vector<std::string> samples(const Position& pos, int k);
+
+	//T̍ pos ̐F̕Ȃ̋ɐԂ̊mn (T̊mm[hp).
+	//MO pos ǂĂȂ, c̐Ԃ̌lȊmɂ.
+	void set_red_probs(Position& pos);
+}
+#endif
@@ -43,28 +43,18 @@ Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
 //}
 
 
-/// safe_destination() returns the bitboard of target square for the given step
-/// from the given square. If the step is off the board, returns empty bitboard.
-
-inline Bitboard safe_destination(Square s, int step) {
-    Square to = Square(s + step);
-    return is_ok_B(to) && distance(s, to) <= 2 ? square_bb(to) : Bitboard(0);
-}
-inline Bitboard safe_destination(Square s, int step, PieceType pt) {
-  Square to = Square(s + step);
-  switch (pt)
-  {
-  case BLUE:
-    return is_ok_B(to) && distance(s, to) <= 1 ? square_bb(to) : Bitboard(0);
-  case RED:
-    return is_ok_R(to) && distance(s, to) <= 1 ? square_bb(to) : Bitboard(0);
-  case PURPLE:
-    return is_ok_B(to) && distance(s, to) <= 1 ? square_bb(to) : Bitboard(0);
-  case GOAL:
-    return is_ok_B(to) && distance(s, to) <= 1 ? square_bb(to) : Bitboard(0);
-  default:
-    return is_ok_B(to) && distance(s, to) <= 1 ? square_bb(to) : Bitboard(0);
-  }
+/// safe_destination() returns the bitboard of the square one step (df, dr)
+/// away from the given square. If the step is off the board, or reaches a goal
+/// square with a piece that can not escape, returns empty bitboard.
+
+inline Bitboard safe_destination(Square s, int df, int dr, PieceType pt) {
+  File f = File(file_of(s) + df);
+  Rank r = Rank(rank_of(s) + dr);
+  if (f < FILE_A || f > FILE_F)
+      return 0;
+
+  Square to = make_square(f, r);
+  return (pt == RED ? is_ok_R(to) : is_ok_B(to)) ? square_bb(to) : Bitboard(0);
 }
 
 
@@ -73,16 +63,19 @@ inline Bitboard safe_destination(Square s, int step, PieceType pt) {
 
 const std::string Bitboards::pretty(Bitboard b) {
 
-  std::string s = "+---+---+---+---+---+---+---+---+\n";
+  std::string s = "+---+---+---+---+---+---+\n";
 
-  for (Rank r = RANK_8; r >= RANK_1; --r)
+  for (Rank r = RANK_7; r >= RANK_0; --r)
   {
-      for (File f = FILE_A; f <= FILE_H; ++f)
-          s += b & make_square(f, r) ? "| X " : "|   ";
+      for (File f = FILE_A; f <= FILE_F; ++f)
+      {
+          Square sq = make_square(f, r);
+          s += !is_ok(sq) ? "    " : b & sq ? "| X " : "|   ";
+      }
 
-      s += "| " + std::to_string(1 + r) + "\n+---+---+---+---+---+---+---+---+\n";
+      s += "| " + std::to_string(1 + r) + "\n+---+---+---+---+---+---+\n";
   }
-  s += "  a   b   c   d   e   f   g   h\n";
+  s += "  a   b   c   d   e   f\n";
 
   return s;
 }
@@ -96,47 +89,34 @@ void Bitboards::init() {
   for (unsigned i = 0; i < (1 << 16); ++i)
       PopCnt16[i] = uint8_t(std::bitset<16>(i).count());
   
-  for (Square s = SQ_A1; s <= SQ_H8; ++s)
+  for (Square s = SQ_A1; s <= SQ_F7; ++s)
       SquareBB[s] = (1ULL << s);
 
-  for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
-      for (Square s2 = SQ_A1; s2 <= SQ_H8; ++s2)
+  for (Square s1 = SQ_A1; s1 <= SQ_F7; ++s1)
+      for (Square s2 = SQ_A1; s2 <= SQ_F7; ++s2)
           SquareDistance[s1][s2] = std::max(distance<File>(s1, s2), distance<Rank>(s1, s2));
 
   //init_magics(ROOK, RookTable, RookMagics);
   //init_magics(BISHOP, BishopTable, BishopMagics);
 
-  for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
+  //͓̂6*6炾. S[̃}X̗0̂܂
+  for (Square s1 = SQ_A1; s1 <= SQ_F6; ++s1)
   {
-    if (!is_ok_R(s1)) continue;
-
       //PawnAttacks[WHITE][s1] = pawn_attacks_bb<WHITE>(square_bb(s1));
       //PawnAttacks[BLACK][s1] = pawn_attacks_bb<BLACK>(square_bb(s1));
 
-      //AAE݂Ȋ̐
-      //vɉ̓
-      for (int step : {-8, -1, 1, 8}) {
-        PseudoAttacks[BLUE][s1] |= safe_destination(s1, step, BLUE);
-        PseudoAttacks[RED][s1] |= safe_destination(s1, step, RED);
-        PseudoAttacks[PURPLE][s1] |= safe_destination(s1, step, PURPLE);
+      //㉺E1}X. ԋȊO̓S[ɂi߂
+      const int df[4] = { 0, 1, 0, -1 };
+      const int dr[4] = { 1, 0, -1, 0 };
+      for (int i = 0; i < 4; i++) {
+        PseudoAttacks[BLUE][s1] |= safe_destination(s1, df[i], dr[i], BLUE);
+        PseudoAttacks[RED][s1] |= safe_destination(s1, df[i], dr[i], RED);
+        PseudoAttacks[PURPLE][s1] |= safe_destination(s1, df[i], dr[i], PURPLE);
       }
 
       //for (int step : {-9, -8, -7, -1, 1, 7, 8, 9} )
       //   PseudoAttacks[KING][s1] |= safe_destination(s1, step);
       PseudoAttacks[GOAL][s1] = 0;
-
-      /*
-      for (int step : {-17, -15, -10, -6, 6, 10, 15, 17} )
-         PseudoAttacks[KNIGHT][s1] |= safe_destination(s1, step);
-
-      PseudoAttacks[QUEEN][s1]  = PseudoAttacks[BISHOP][s1] = attacks_bb<BISHOP>(s1, 0);
-      PseudoAttacks[QUEEN][s1] |= PseudoAttacks[  ROOK][s1] = attacks_bb<  ROOK>(s1, 0);
-
-      for (PieceType pt : { BISHOP, ROOK })
-          for (Square s2 = SQ_A1; s2 <= SQ_H8; ++s2)
-              if (PseudoAttacks[pt][s1] & s2)
-                  LineBB[s1][s2] = (attacks_bb(pt, s1, 0) & attacks_bb(pt, s2, 0)) | s1 | s2;
-      */
   }
 }
 
@@ -37,37 +37,24 @@ const std::string pretty(Bitboard b);
 
 }
 
-constexpr Bitboard AllSquares = ~Bitboard(0);
-constexpr Bitboard DarkSquares = 0xAA55AA55AA55AA55ULL;
+constexpr Bitboard AllSquares = (1ULL << SQUARE_NB) - 1;
+constexpr Bitboard BoardBB = (1ULL << SQ_A0) - 1; // 6*636rbg
+constexpr Bitboard GoalBB = AllSquares & ~BoardBB;
+constexpr Bitboard DarkSquares = 0xA95A95A95ULL;
 
-constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileABB = 0x041041041ULL;
 constexpr Bitboard FileBBB = FileABB << 1;
 constexpr Bitboard FileCBB = FileABB << 2;
 constexpr Bitboard FileDBB = FileABB << 3;
 constexpr Bitboard FileEBB = FileABB << 4;
 constexpr Bitboard FileFBB = FileABB << 5;
-constexpr Bitboard FileGBB = FileABB << 6;
-constexpr Bitboard FileHBB = FileABB << 7;
-
-constexpr Bitboard Rank1BB = 0xFF;
-constexpr Bitboard Rank2BB = Rank1BB << (8 * 1);
-constexpr Bitboard Rank3BB = Rank1BB << (8 * 2);
-constexpr Bitboard Rank4BB = Rank1BB << (8 * 3);
-constexpr Bitboard Rank5BB = Rank1BB << (8 * 4);
-constexpr Bitboard Rank6BB = Rank1BB << (8 * 5);
-constexpr Bitboard Rank7BB = Rank1BB << (8 * 6);
-constexpr Bitboard Rank8BB = Rank1BB << (8 * 7);
-
-constexpr Bitboard QueenSide   = FileABB | FileBBB | FileCBB | FileDBB;
-constexpr Bitboard CenterFiles = FileCBB | FileDBB | FileEBB | FileFBB;
-constexpr Bitboard KingSide    = FileEBB | FileFBB | FileGBB | FileHBB;
-constexpr Bitboard Center      = (FileDBB | FileEBB) & (Rank4BB | Rank5BB);
-
-constexpr Bitboard KingFlank[FILE_NB] = {
-  QueenSide ^ FileDBB, QueenSide, QueenSide,
-  CenterFiles, CenterFiles,
-  KingSide, KingSide, KingSide ^ FileEBB
-};
+
+constexpr Bitboard Rank1BB = 0x3F;
+constexpr Bitboard Rank2BB = Rank1BB << (6 * 1);
+constexpr Bitboard Rank3BB = Rank1BB << (6 * 2);
+constexpr Bitboard Rank4BB = Rank1BB << (6 * 3);
+constexpr Bitboard Rank5BB = Rank1BB << (6 * 4);
+constexpr Bitboard Rank6BB = Rank1BB << (6 * 5);
 
 extern uint8_t PopCnt16[1 << 16];
 extern uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
@@ -141,7 +128,7 @@ constexpr bool opposite_colors(Square s1, Square s2) {
 /// the given file or rank.
 
 constexpr Bitboard rank_bb(Rank r) {
-  return Rank1BB << (8 * r);
+  return Rank1BB << (6 * r);
 }
 
 constexpr Bitboard rank_bb(Square s) {
@@ -161,11 +148,11 @@ constexpr Bitboard file_bb(Square s) {
 
 template<Direction D>
 constexpr Bitboard shift(Bitboard b) {
-  return  D == NORTH      ?  b             << 8 : D == SOUTH      ?  b             >> 8
-        : D == NORTH+NORTH?  b             <<16 : D == SOUTH+SOUTH?  b             >>16
-        : D == EAST       ? (b & ~FileHBB) << 1 : D == WEST       ? (b & ~FileABB) >> 1
-        : D == NORTH_EAST ? (b & ~FileHBB) << 9 : D == NORTH_WEST ? (b & ~FileABB) << 7
-        : D == SOUTH_EAST ? (b & ~FileHBB) >> 7 : D == SOUTH_WEST ? (b & ~FileABB) >> 9
+  return  D == NORTH      ?  b             << 6 & BoardBB : D == SOUTH      ? (b & BoardBB)    >> 6
+        : D == NORTH+NORTH?  b             <<12 & BoardBB : D == SOUTH+SOUTH? (b & BoardBB)    >>12
+        : D == EAST       ? (b & ~FileFBB) << 1 & BoardBB : D == WEST       ? (b & ~FileABB & BoardBB) >> 1
+        : D == NORTH_EAST ? (b & ~FileFBB) << 7 & BoardBB : D == NORTH_WEST ? (b & ~FileABB) << 5 & BoardBB
+        : D == SOUTH_EAST ? (b & ~FileFBB & BoardBB) >> 5 : D == SOUTH_WEST ? (b & ~FileABB & BoardBB) >> 7
         : 0;
 }
 
@@ -234,8 +221,8 @@ inline Bitboard line_bb(Square s1, Square s2) {
 /// forward_ranks_bb(BLACK, SQ_D3) will return the 16 squares on ranks 1 and 2.
 
 constexpr Bitboard forward_ranks_bb(Color c, Square s) {
-  return c == WHITE ? ~Rank1BB << 8 * relative_rank(WHITE, s)
-                    : ~Rank8BB >> 8 * relative_rank(BLACK, s);
+  return c == WHITE ? ~Rank1BB << 6 * relative_rank(WHITE, s) & BoardBB
+                    : (BoardBB & ~Rank6BB) >> 6 * relative_rank(BLACK, s);
 }
 
 
@@ -281,8 +268,8 @@ template<> inline int distance<File>(Square x, Square y) { return std::abs(file_
 template<> inline int distance<Rank>(Square x, Square y) { return std::abs(rank_of(x) - rank_of(y)); }
 template<> inline int distance<Square>(Square x, Square y) { return SquareDistance[x][y]; }
 
-inline int edge_distance(File f) { return std::min(f, File(FILE_H - f)); }
-inline int edge_distance(Rank r) { return std::min(r, Rank(RANK_8 - r)); }
+inline int edge_distance(File f) { return std::min(f, File(FILE_F - f)); }
+inline int edge_distance(Rank r) { return std::min(r, Rank(RANK_6 - r)); }
 
 
 /// attacks_bb(Square) returns the pseudo attacks of the give piece type
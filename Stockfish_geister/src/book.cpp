@@ -0,0 +1,384 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "bitboard.h"
+#include "book.h"
+#include "misc.h"
+#include "position.h"
+#include "tcp.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#  define NOMINMAX // Disable macros min() and max()
+#endif
+#include <windows.h>
+#endif
+
+using namespace Book;
+
+namespace {
+
+// A book file is an 8 bytes header (magic and number of entries), the Stats
+// of the 256 red masks (bit i set when ghost 'A' + i is red, only the 70 masks
+// with 4 bits set are used) and the entries sorted by key, all in the byte
+// order of the machine that wrote it (little-endian on all the targets).
+
+constexpr char BookMagic[] = { 'G', 'B', 'K', 1 };
+constexpr int MaskNb = 256;
+constexpr int GhostNb = 16;
+constexpr size_t HeaderSize = 8 + MaskNb * sizeof(Stats);
+
+static_assert(HeaderSize % alignof(Entry) == 0, "Entries are not aligned");
+
+// A placement is chosen at random among the ones that scored within this
+// much of the best one, so that the opponent cannot count on a single one
+constexpr double PlacementMargin = 0.05;
+
+uint64_t Psq[3][SQUARE_NB]; // Our blues, our reds and their ghosts
+
+void* baseAddress;
+uint64_t mapping;
+const Stats* placements;
+const Entry* entries;
+size_t entryCount;
+
+int ghosts(const Position& pos) {
+  return pos.count<ALL_PIECES>() - pos.count<GOAL>();
+}
+
+void unmap() {
+
+  if (!baseAddress)
+      return;
+
+#ifndef _WIN32
+  munmap(baseAddress, mapping);
+#else
+  UnmapViewOfFile(baseAddress);
+  CloseHandle((HANDLE)mapping);
+#endif
+
+  baseAddress = nullptr, placements = nullptr, entries = nullptr, entryCount = 0;
+}
+
+// map() memory maps the book file and returns its size, or 0 if it can not
+// be opened.
+uint64_t map(const std::string& fname) {
+
+#ifndef _WIN32
+  struct stat statbuf;
+  int fd = ::open(fname.c_str(), O_RDONLY);
+
+  if (fd == -1)
+      return 0;
+
+  fstat(fd, &statbuf);
+  mapping = statbuf.st_size;
+  baseAddress = statbuf.st_size ? mmap(nullptr, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  ::close(fd);
+
+  if (baseAddress == MAP_FAILED)
+      return baseAddress = nullptr, 0;
+
+  return statbuf.st_size;
+#else
+  HANDLE fd = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (fd == INVALID_HANDLE_VALUE)
+      return 0;
+
+  DWORD size_high;
+  DWORD size_low = GetFileSize(fd, &size_high);
+  HANDLE mmap = CreateFileMapping(fd, nullptr, PAGE_READONLY, size_high, size_low, nullptr);
+  CloseHandle(fd);
+
+  if (!mmap)
+      return 0;
+
+  mapping = (uint64_t)mmap;
+  baseAddress = MapViewOfFile(mmap, FILE_MAP_READ, 0, 0, 0);
+
+  if (!baseAddress)
+      return CloseHandle(mmap), 0;
+
+  return (uint64_t(size_high) << 32) | size_low;
+#endif
+}
+
+// Stats are stored in 16 bits. Larger counts are scaled down together so
+// that the score is kept.
+Stats pack(const uint64_t r[3]) {
+
+  uint64_t games = r[0] + r[1] + r[2];
+  uint64_t div = games > 0xFFFF ? (games + 0xFFFE) / 0xFFFF : 1;
+
+  return { uint16_t(r[0] / div), uint16_t(r[1] / div), uint16_t(r[2] / div) };
+}
+
+
+// Generator is told about the self-play games by tcp::selfPlay(). For both
+// sides it keeps the book positions of the game and the move played in them
+// and, at the end of the game, adds the result to the placement, to each of
+// the positions and to the number of times each move was played in them.
+// Book positions get 'searchtime' instead of the game clock, so that the
+// moves played in them are the pre-searched replies of the book.
+
+struct Generator : public tcp::GameObserver {
+
+  struct Node {
+    uint64_t results[3]; // Wins, losses and draws for the side to move
+    std::map<Move, int> played;
+  };
+
+  int searchtime, plies;
+  std::map<uint64_t, Node> nodes;
+  uint64_t masks[MaskNb][3];
+  int reds[2];
+  std::vector<std::pair<uint64_t, Move>> line[2];
+
+  Generator(int t, int p) : searchtime(t), plies(p), masks() {}
+
+  bool in_book(const Position& pos, int side) const {
+    return int(line[side].size()) < plies && ghosts(pos) == GhostNb;
+  }
+
+  void start(const std::string& reds0, const std::string& reds1) override {
+
+    for (int side : { 0, 1 })
+    {
+        reds[side] = 0;
+        for (char c : side ? reds1 : reds0)
+            reds[side] |= 1 << (c - 'A');
+        line[side].clear();
+    }
+  }
+
+  int search_time(const Position& pos, int side) override {
+    return in_book(pos, side) ? searchtime : 0;
+  }
+
+  void move(const Position& pos, int side, Move m, Value, const std::string&) override {
+    if (in_book(pos, side))
+        line[side].emplace_back(key(pos), m);
+  }
+
+  void end(int winner) override {
+
+    for (int side : { 0, 1 })
+    {
+        int r = winner == -1 ? 2 : winner == side ? 0 : 1;
+
+        masks[reds[side]][r]++;
+
+        for (const auto& e : line[side])
+        {
+            Node& n = nodes[e.first];
+            n.results[r]++;
+            n.played[e.second]++;
+        }
+    }
+  }
+};
+
+} // namespace
+
+
+/// Book::init() maps the book file at 'path'. An empty path or "<empty>"
+/// switches the book off.
+
+void Book::init(const std::string& path) {
+
+  static bool initialized = false;
+
+  if (!initialized)
+  {
+      PRNG rng(0x4765697374657221); // Fixed, the keys are stored in the files
+
+      for (auto& sqs : Psq)
+          for (uint64_t& k : sqs)
+              k = rng.rand<uint64_t>();
+
+      initialized = true;
+  }
+
+  unmap();
+
+  if (path.empty() || path == "<empty>")
+      return;
+
+  uint64_t size = map(path);
+  const char* data = (const char*)baseAddress;
+
+  if (!size)
+  {
+      sync_cout << "info string Could not open book " << path << sync_endl;
+      return;
+  }
+
+  uint32_t count;
+
+  if (   size < HeaderSize
+      || memcmp(data, BookMagic, 4)
+      || (std::memcpy(&count, data + 4, 4), size != HeaderSize + uint64_t(count) * sizeof(Entry)))
+  {
+      sync_cout << "info string Corrupt book " << path << sync_endl;
+      unmap();
+      return;
+  }
+
+  placements = (const Stats*)(data + 8);
+  entries = (const Entry*)(data + HeaderSize);
+  entryCount = count;
+
+  sync_cout << "info string Found " << entryCount << " book positions" << sync_endl;
+}
+
+
+/// Book::key() is the hash of the ghosts on the board. The opponent's ghosts
+/// all hash the same, so that the key does not depend on our guesses about
+/// their colours.
+
+uint64_t Book::key(const Position& pos) {
+
+  uint64_t k = 0;
+
+  for (Square s = SQ_A1; s <= SQ_F6; ++s)
+  {
+      Piece pc = pos.piece_on(s);
+
+      if (pc != NO_PIECE)
+          k ^= Psq[color_of(pc) == BLACK ? 2 : type_of(pc) == RED][s];
+  }
+
+  return k;
+}
+
+
+/// Book::probe() returns the book entry of the position, or nullptr if there
+/// is none.
+
+const Entry* Book::probe(const Position& pos) {
+
+  if (!entryCount || ghosts(pos) != GhostNb)
+      return nullptr;
+
+  uint64_t k = key(pos);
+  const Entry* e = std::lower_bound(entries, entries + entryCount, k,
+                                    [](const Entry& a, uint64_t b) { return a.key < b; });
+
+  return e != entries + entryCount && e->key == k ? e : nullptr;
+}
+
+
+/// Book::placement() returns the red ghosts to send in the SET: message, e.g.
+/// "BCEH", chosen among the best placements of the book. It returns an empty
+/// string when the book has no games for any placement.
+
+std::string Book::placement() {
+
+  if (!placements)
+      return "";
+
+  std::vector<int> best;
+  double bestScore = 0;
+
+  for (int m = 0; m < MaskNb; ++m)
+      if (popcount(Bitboard(m)) == 4 && placements[m].games())
+          bestScore = std::max(bestScore, placements[m].score());
+
+  for (int m = 0; m < MaskNb; ++m)
+      if (   popcount(Bitboard(m)) == 4 && placements[m].games()
+          && placements[m].score() >= bestScore - PlacementMargin)
+          best.push_back(m);
+
+  if (best.empty())
+      return "";
+
+  std::string reds;
+  int m = best[rand() % best.size()];
+
+  for (int i = 0; i < 8; ++i)
+      if (m & (1 << i))
+          reds += char('A' + i);
+
+  return reds;
+}
+
+
+/// Book::generate() plays 'games' self-play games with 'movetime' ms per move,
+/// and 'searchtime' ms for each of the first 'plies' moves of a side before
+/// the first capture, and writes the book of these games to 'path'. The reply
+/// of a position is the move played most often in it, and its Stats are the
+/// results of all the games that went through it. The loaded book, if any,
+/// is switched off during the games.
+
+void Book::generate(int games, int movetime, int searchtime, int plies, const std::string& path) {
+
+  init("");
+
+  Generator gen(searchtime, plies);
+  tcp::selfPlay(games, movetime, "result.txt", &gen);
+
+  std::vector<Entry> book;
+
+  for (const auto& n : gen.nodes)
+  {
+      // Most played move, the lowest one on a tie to be reproducible
+      auto best = std::max_element(n.second.played.begin(), n.second.played.end(),
+                                   [](const std::pair<const Move, int>& a, const std::pair<const Move, int>& b) {
+                                       return a.second < b.second; });
+
+      book.push_back({ n.first, uint16_t(best->first), pack(n.second.results) });
+  }
+
+  // std::map iterates in key order, so the entries are already sorted
+  Stats masks[MaskNb];
+  for (int m = 0; m < MaskNb; ++m)
+      masks[m] = pack(gen.masks[m]);
+
+  uint32_t count = uint32_t(book.size());
+  std::ofstream out(path, std::ios::binary);
+
+  out.write(BookMagic, 4);
+  out.write((const char*)&count, 4);
+  out.write((const char*)masks, sizeof(masks));
+  out.write((const char*)book.data(), book.size() * sizeof(Entry));
+
+  if (!out)
+  {
+      std::cerr << "Could not write book " << path << std::endl;
+      return;
+  }
+
+  std::cerr << "Book positions : " << count << "\nBook file      : " << path << std::endl;
+}
@@ -0,0 +1,70 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOK_H_INCLUDED
+#define BOOK_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+
+class Position;
+
+/// The Book namespace is the opening book: the red placement to choose at
+/// SET time and a pre-searched reply for the positions of the first moves,
+/// both with the results of the self-play games they were seen in. A book
+/// file is built offline by generate() and memory mapped by init().
+///
+/// A position is known by the squares of our blue and red ghosts and of the
+/// opponent's ghosts, whatever colour we believe them to be, so our own
+/// placement and the opponent's moves so far are both part of it. Only
+/// positions before the first capture are in the book.
+
+namespace Book {
+
+/// Stats are the results of the self-play games, for the side that placed
+/// the ghosts or that is to move in the position.
+
+struct Stats {
+  uint16_t wins, losses, draws;
+
+  int games() const { return wins + losses + draws; }
+
+  // Expected score in [0, 1], with one win and one loss added so that rarely
+  // played entries stay near 0.5
+  double score() const { return (wins + draws / 2.0 + 1) / (games() + 2); }
+};
+
+struct Entry {
+  uint64_t key;
+  uint16_t move;
+  Stats stats;
+};
+
+static_assert(sizeof(Entry) == 16, "Entry size incorrect");
+
+void init(const std::string& path);
+uint64_t key(const Position& pos);
+const Entry* probe(const Position& pos);
+std::string placement();
+void generate(int games, int movetime, int searchtime, int plies, const std::string& path);
+
+} // namespace Book
+
+#endif // #ifndef BOOK_H_INCLUDED
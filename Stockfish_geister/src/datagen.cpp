@@ -0,0 +1,184 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "book.h"
+#include "datagen.h"
+#include "misc.h"
+#include "tcp.h"
+#include "uci.h"
+
+using namespace Datagen;
+
+namespace {
+
+// Records are written out this many at a time
+constexpr size_t BufferSize = 4096;
+
+// The letters of the pieces, those of PieceToChar in the board strings of the
+// game server, and '-' for an empty square
+const std::string PieceChars("-BR      br     ");
+
+// Generator is told about the self-play games by tcp::selfPlay(). It searches
+// every move for a fixed number of nodes, keeps the records of the game until
+// its result is known and then adds them to its buffer, which is written out
+// whenever it is full.
+
+struct Generator : public tcp::GameObserver {
+
+  int64_t nodes;
+  std::ofstream& out;
+  std::vector<Record> buffer, line[2];
+  uint64_t positions = 0;
+  int ply = 0;
+
+  Generator(int64_t n, std::ofstream& o) : nodes(n), out(o) { buffer.reserve(BufferSize); }
+
+  void flush() {
+    out.write((const char*)buffer.data(), buffer.size() * sizeof(Record));
+    buffer.clear();
+  }
+
+  void start(const std::string&, const std::string&) override {
+    line[0].clear(), line[1].clear();
+    ply = 0;
+  }
+
+  int64_t search_nodes(const Position&, int) override { return nodes; }
+
+  // The board string is read as in Position::set(), "xyC" for each ghost,
+  // where the captured ones are at (9, 9).
+  void move(const Position&, int side, Move m, Value score, const std::string& board) override {
+
+    Record r = {};
+
+    for (size_t i = 0; i + 2 < board.size(); i += 3)
+    {
+        int x = board[i] - '0', y = board[i + 1] - '0';
+        size_t pc = PieceChars.find(board[i + 2]);
+
+        if (x < FILE_NB && y < RANK_NB && pc != std::string::npos)
+        {
+            Square s = make_square(File(x), Rank(y));
+            r.board[s / 2] |= uint8_t(pc << (s % 2 * 4));
+        }
+    }
+
+    r.score = int16_t(std::abs(score) < VALUE_INFINITE ? score : VALUE_NONE);
+    r.move = uint16_t(m);
+    r.ply = uint16_t(ply++);
+    r.side = uint8_t(side);
+    line[side].push_back(r);
+  }
+
+  void end(int winner) override {
+
+    for (int side : { 0, 1 })
+        for (Record& r : line[side])
+        {
+            r.result = int8_t(winner == -1 ? 0 : winner == side ? 1 : -1);
+            buffer.push_back(r);
+            positions++;
+
+            if (buffer.size() == BufferSize)
+                flush();
+        }
+  }
+};
+
+} // namespace
+
+
+/// Datagen::read() reads the next record of a training data stream. It returns
+/// false at the end of the stream.
+
+bool Datagen::read(std::istream& is, Record& r) {
+
+  return bool(is.read((char*)&r, sizeof(Record)));
+}
+
+
+/// Datagen::generate() plays 'games' self-play games, searching each move for
+/// 'nodes' nodes, and appends the records of all their positions to the file
+/// at 'path'. The games follow from 'seed', so runs in several processes, one
+/// per core and each with its own seed and file, give different positions:
+/// scripts/datagen.sh starts them and merges their files.
+/// The loaded book, if any, is switched off during the games.
+
+void Datagen::generate(int games, int64_t nodes, unsigned seed, const std::string& path) {
+
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+
+  if (!out)
+  {
+      std::cerr << "Could not write training data " << path << std::endl;
+      return;
+  }
+
+  Book::init("");
+
+  Generator gen(nodes, out);
+  TimePoint elapsed = now();
+
+  tcp::selfPlay(games, 1000, "result.txt", &gen, seed);
+  gen.flush();
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  uint64_t pps = 1000 * gen.positions / elapsed;
+
+  std::cerr << "Positions      : " << gen.positions
+            << "\nPositions/sec  : " << pps
+            << "\nTraining data  : " << path << std::endl;
+}
+
+
+/// Datagen::dump() prints the first 'count' records of the file at 'path', all
+/// of them if 'count' is 0, one per line: the pieces of the 36 squares from
+/// SQ_A1 to SQ_F6 ('-' for an empty one), the score, the move, the ply, the
+/// result and the player to move. It is meant for the training scripts.
+
+void Datagen::dump(const std::string& path, uint64_t count) {
+
+  std::ifstream in(path, std::ios::binary);
+  Record r;
+
+  if (!in)
+  {
+      std::cerr << "Could not open training data " << path << std::endl;
+      return;
+  }
+
+  for (uint64_t n = 0; (!count || n < count) && read(in, r); ++n)
+  {
+      std::string board;
+
+      for (Square s = SQ_A1; s <= SQ_F6; ++s)
+          board += PieceChars[r.piece_on(s)];
+
+      std::cout << board << ' ' << r.score << ' ' << UCI::move(Move(r.move), false)
+                << ' ' << r.ply << ' ' << int(r.result) << ' ' << int(r.side) << '\n';
+  }
+
+  std::cout << std::flush;
+}
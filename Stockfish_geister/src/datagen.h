@@ -0,0 +1,63 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DATAGEN_H_INCLUDED
+#define DATAGEN_H_INCLUDED
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "types.h"
+
+/// The Datagen namespace writes the positions of fast self-play games as
+/// training data for the evaluation: a stream of fixed-width records, with
+/// neither header nor separator, so that the files of several runs can just
+/// be concatenated. Records are in the byte order of the machine that wrote
+/// them (little-endian on all the targets).
+
+namespace Datagen {
+
+/// Record is one position, seen by the side to move: our ghosts are WHITE
+/// and the opponent's BLACK, with their true colours. Each square holds its
+/// Piece in 4 bits, the even squares in the low half of the byte. The score
+/// is that of the search for the side to move (VALUE_NONE when there was no
+/// search) and the result that of the game: 1 for a win, 0 for a draw and
+/// -1 for a loss.
+
+struct Record {
+  uint8_t board[(SQ_F6 + 1) / 2];
+  int16_t score;
+  uint16_t move;
+  uint16_t ply;   // Plies played before the position
+  int8_t result;
+  uint8_t side;   // Player to move, 0 or 1 as in result.txt
+
+  Piece piece_on(Square s) const { return Piece((board[s / 2] >> (s % 2 * 4)) & 0xF); }
+};
+
+static_assert(sizeof(Record) == 26, "Record size incorrect");
+
+bool read(std::istream& is, Record& r);
+void generate(int games, int64_t nodes, unsigned seed, const std::string& path);
+void dump(const std::string& path, uint64_t count);
+
+} // namespace Datagen
+
+#endif // #ifndef DATAGEN_H_INCLUDED
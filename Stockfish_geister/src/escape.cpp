@@ -0,0 +1,244 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "bitboard.h"
+#include "escape.h"
+#include "Game_geister.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace {
+
+  // Proofs are given up after this many nodes, so that the solver never
+  // delays the search by more than a few milliseconds
+  constexpr uint64_t NodeLimit = 20000;
+
+  constexpr int MaxDistance = 10;
+
+  // InReach[c][n] are the squares from which a runner of colour c may escape
+  // within n moves: it needs the distance to the nearest exit to get there
+  // and one more move to escape.
+  Bitboard InReach[COLOR_NB][MaxDistance + 2];
+
+  Bitboard exits(Color c) {
+    return c == WHITE ? SQ_A1 | SQ_F1 : SQ_A6 | SQ_F6;
+  }
+
+  Bitboard runners(const Position& pos, Color c) {
+    return pos.pieces(c, BLUE, PURPLE);
+  }
+
+  Bitboard in_reach(Color c, int moves) {
+    return InReach[c][std::min(moves, MaxDistance + 1)];
+  }
+
+  // Solver proves the escapes by an AND/OR search on the legal moves. Moves
+  // are counted for the side that escapes (the attacker), and a node is left
+  // as soon as none of its runners is in reach of an exit.
+
+  struct Solver {
+
+    Solver(Position& p) : pos(p),
+      ghosts(p.count<ALL_PIECES>(BLACK) - p.count<GOAL>(BLACK)),
+      reds(Game_::rNum), blues(Game_::bNum) {}
+
+    bool attack(int n, Move& best);
+    bool defend(int n);
+
+    // Black ghosts captured since the root, of either colour
+    int taken() const {
+      return ghosts - (pos.count<ALL_PIECES>(BLACK) - pos.count<GOAL>(BLACK));
+    }
+
+    // Our own ghosts are known, so the captures of White's ghosts and the
+    // escapes (captures of a goal) are certain to end the game or not
+    bool certain(Move m) const {
+      Piece pc = pos.piece_on(to_sq(m));
+      return pc != NO_PIECE && (color_of(pc) == WHITE || type_of(pc) == GOAL);
+    }
+
+    // may_win() and may_lose() tell whether a move could end the game, won
+    // or lost for the side that plays it
+    bool may_win(Move m) const {
+      Piece pc = pos.piece_on(to_sq(m));
+      return   pc != NO_PIECE
+            && (   type_of(pc) == GOAL
+                || (pc == W_BLUE && pos.count<BLUE>(WHITE) == 1)
+                || (color_of(pc) == BLACK && blues - taken() <= 1));
+    }
+
+    bool may_lose(Move m) const {
+      Piece pc = pos.piece_on(to_sq(m));
+      return   pc != NO_PIECE
+            && (   (pc == W_RED && pos.count<RED>(WHITE) == 1)
+                || (color_of(pc) == BLACK && type_of(pc) != GOAL && reds - taken() <= 1));
+    }
+
+    Position& pos;
+    int ghosts, reds, blues; // Black ghosts, reds and blues at the root
+    uint64_t nodes = 0;
+  };
+
+  // attack() is true when the side to move escapes within 'n' of its moves
+  // whatever the opponent plays, and then sets 'best' to the move to play.
+
+  bool Solver::attack(int n, Move& best) {
+
+    Color us = pos.side_to_move();
+
+    if (++nodes > NodeLimit || !(runners(pos, us) & in_reach(us, n)))
+        return false;
+
+    MoveList<LEGAL> moves(pos);
+
+    for (const auto& m : moves)
+        if (may_win(m) && certain(m))
+        {
+            best = m;
+            return true;
+        }
+
+    if (n == 1)
+        return false;
+
+    StateInfo st;
+
+    for (const auto& m : moves)
+    {
+        if (may_lose(m))
+            continue;
+
+        pos.do_move(m, st);
+        bool won = defend(n - 1);
+        pos.undo_move(m);
+
+        if (won)
+        {
+            best = m;
+            return true;
+        }
+    }
+
+    return false;
+  }
+
+  // defend() is true when the opponent of the side to move escapes within
+  // 'n' of its moves whatever the side to move plays.
+
+  bool Solver::defend(int n) {
+
+    Color us = pos.side_to_move();
+
+    if (++nodes > NodeLimit || !(runners(pos, ~us) & in_reach(~us, n)))
+        return false;
+
+    MoveList<LEGAL> moves(pos);
+
+    if (!moves.size())
+        return false;
+
+    for (const auto& m : moves)
+        if (may_win(m))
+            return false;
+
+    StateInfo st;
+    Move best;
+
+    for (const auto& m : moves)
+    {
+        if (may_lose(m) && certain(m))
+            continue;
+
+        pos.do_move(m, st);
+        bool lost = attack(n, best);
+        pos.undo_move(m);
+
+        if (!lost)
+            return false;
+    }
+
+    return true;
+  }
+
+} // namespace
+
+
+/// Escape::init() initializes the distances to the exits
+
+void Escape::init() {
+
+  for (Color c : { WHITE, BLACK })
+      for (Square s = SQ_A1; s <= SQ_F6; ++s)
+      {
+          int d = MaxDistance;
+          Bitboard b = exits(c);
+
+          while (b)
+          {
+              Square e = pop_lsb(&b);
+              d = std::min(d, std::abs(file_of(s) - file_of(e)) + std::abs(rank_of(s) - rank_of(e)));
+          }
+
+          for (int n = d + 1; n <= MaxDistance + 1; ++n)
+              InReach[c][n] |= s;
+      }
+}
+
+
+/// Escape::solve() returns the value of a solved race with the move to play
+/// in 'best', or VALUE_NONE. The escapes of the side to move are tried first,
+/// the shortest one first. Otherwise, when every move lets the opponent
+/// escape, the move that holds out longest is played.
+
+Value Escape::solve(Position& pos, Move& best) {
+
+  Solver solver(pos);
+
+  for (int n = 1; n <= MaxMoves; ++n)
+      if (solver.attack(n, best))
+          return mate_in(2 * n - 1);
+
+  StateInfo st;
+  Move reply;
+  int longest = 0;
+
+  for (const auto& m : MoveList<LEGAL>(pos))
+  {
+      if (solver.may_win(m))
+          return VALUE_NONE;
+
+      pos.do_move(m, st);
+
+      int n = 1;
+      while (n <= MaxMoves && !solver.attack(n, reply))
+          ++n;
+
+      pos.undo_move(m);
+
+      if (n > MaxMoves || solver.nodes > NodeLimit)
+          return VALUE_NONE;
+
+      if (n > longest)
+          longest = n, best = m;
+  }
+
+  return longest ? mated_in(2 * longest) : VALUE_NONE;
+}
@@ -0,0 +1,44 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ESCAPE_H_INCLUDED
+#define ESCAPE_H_INCLUDED
+
+#include "types.h"
+
+class Position;
+
+/// The Escape namespace is an exact solver for escape races, run before the
+/// search. It proves, with a few moves of the runners, either that the side
+/// to move escapes whatever the opponent does, or that the opponent escapes
+/// whatever the side to move does. As in the search, the opponent's ghosts
+/// of unknown colour may escape and the one marked red, if any, may not. Any
+/// capture of one of their ghosts that could be of their last red or last
+/// blue is taken as a possible loss or win, so that a proof does not depend
+/// on the colours of the others.
+
+namespace Escape {
+
+constexpr int MaxMoves = 3; // Longest race solved, in moves of the runner
+
+void init();
+Value solve(Position& pos, Move& best);
+
+} // namespace Escape
+
+#endif // #ifndef ESCAPE_H_INCLUDED
@@ -1149,29 +1149,49 @@ std::string Eval::trace(const Position& pos) {
 #include <algorithm>
 #include <vector>
 
+#include "belief.h"
 #include "evaluate.h"
 #include "position.h"
 #include "Game_geister.h"
 #include "search.h"
+#ifdef TUNING
+#include "tune.h"
+#endif
 
 namespace {
-  int _myGoalDist_0[1 << 16];	//_myGoalDist[s] = (sirbgڂ1̃}Xiɋ)Ƃ̃S[܂ł̃}nb^̘a.
-  int _yourGoalDist_0[1 << 16];
-  int _myGoalDist_1[1 << 16]; //ʒũXRAI
-  int _yourGoalDist_1[1 << 16];
-  int bitCountTable[1 << 16];
-
-  inline int myGoalDist_0(long long s) {
-    return _myGoalDist_0[s >> 8 & 65535] + _myGoalDist_0[s >> 24 & 65535] + bitCountTable[s >> 24 & 65535] * 2 + _myGoalDist_0[s >> 40 & 65535] + bitCountTable[s >> 40 & 65535] * 4;
+  // Weights of evaluate_K() and evaluate_P(): a ghost on the board and a step
+  // towards the exits. They are tuned along with the Red weights below.
+  Value ExistWeight = Value(1000);
+  Value DistWeight  = Value(1);
+
+  // Distances of the ghosts to the exits. The distance of a square is the
+  // distance of its file to the nearest corner file (0 to 2) plus the number
+  // of ranks to go, so the sum over a set of ghosts is a weighted count of
+  // them on a few masks, one popcount each: the files at distance 1 and 2,
+  // and the ranks with bit k of their index set. Ranks count twice, and
+  // there is one more move to escape.
+  constexpr Bitboard FileDist1 = FileBBB | FileEBB;
+  constexpr Bitboard FileDist2 = FileCBB | FileDBB;
+  constexpr Bitboard RankBit0  = Rank2BB | Rank4BB | Rank6BB;
+  constexpr Bitboard RankBit1  = Rank3BB | Rank4BB;
+  constexpr Bitboard RankBit2  = Rank5BB | Rank6BB;
+
+  inline int file_dist(Bitboard s) {
+    return popcount(s & FileDist1) + 2 * popcount(s & FileDist2);
   }
-  inline int yourGoalDist_0(long long s) {
-    return _yourGoalDist_0[s >> 8 & 65535] + bitCountTable[s >> 8 & 65535] * 4 + _yourGoalDist_0[s >> 24 & 65535] + bitCountTable[s >> 24 & 65535] * 2 + _yourGoalDist_0[s >> 40 & 65535];
+  inline int rank_sum(Bitboard s) {
+    return popcount(s & RankBit0) + 2 * popcount(s & RankBit1) + 4 * popcount(s & RankBit2);
   }
-  inline int myGoalDist_1(long long s) {
-    return _myGoalDist_1[s >> 8 & 65535] + _myGoalDist_1[s >> 24 & 65535] + bitCountTable[s >> 24 & 65535] * 4 + _myGoalDist_1[s >> 40 & 65535] + bitCountTable[s >> 40 & 65535] * 8;
+
+  // my*: to our exits on the first rank, your*: to the opponent's on the sixth.
+  // The goals outside the 6x6 board are not counted.
+  inline int myGoalDist_1(Bitboard s) {
+    s &= BoardBB;
+    return file_dist(s) + 2 * rank_sum(s) + popcount(s);
   }
-  inline int yourGoalDist_1(long long s) {
-    return _yourGoalDist_1[s >> 8 & 65535] + bitCountTable[s >> 8 & 65535] * 8 + _yourGoalDist_1[s >> 24 & 65535] + bitCountTable[s >> 24 & 65535] * 4 + _yourGoalDist_1[s >> 40 & 65535];
+  inline int yourGoalDist_1(Bitboard s) {
+    s &= BoardBB;
+    return file_dist(s) + 11 * popcount(s) - 2 * rank_sum(s);
   }
 
 
@@ -1244,31 +1264,6 @@ namespace {
 }
 
 
-//O
-void Eval::init() {
-  int i, j;
-  int dist1_0[16] = { 1,0,1,2,2,1,0,1,2,1,2,3,3,2,1,2 };
-  int dist1_1[16] = { 2,1,2,3,3,2,1,2,4,3,4,5,5,4,3,4 };
-  int dist2_0[16] = { 2,1,2,3,3,2,1,2,1,0,1,2,2,1,0,1 };
-  int dist2_1[16] = { 4,3,4,5,5,4,3,4,3,1,2,3,3,2,1,2 };
-
-  for (i = 0; i < (1 << 16); i++) {
-    _myGoalDist_0[i] = 0;
-    _yourGoalDist_0[i] = 0;
-    bitCountTable[i] = 0;
-    for (j = 0; j < 16; j++) {
-      if (((i >> j) & 1) == 0) continue;
-      //}XjS[܂ł̃}nb^
-      _myGoalDist_0[i] += dist1_0[j];
-      _yourGoalDist_0[i] += dist2_0[j];
-      _myGoalDist_1[i] += dist1_1[j];
-      _yourGoalDist_1[i] += dist2_1[j];
-      bitCountTable[i]++;
-    }
-  }
-}
-
-
 Value Eval::evaluate_K(const Position& pos, int ply) {
   //Value v = getWinPlayer_K(pos, ply);
   //if (v != VALUE_ZERO) {
@@ -1301,74 +1296,33 @@ Value Eval::evaluate_P(const Position& pos, int ply) {
     //  return v;
     //}
 
-    Value v = VALUE_ZERO;
     Color us = pos.side_to_move();
-    //GOALɋ߂ꏊɂǂiG
-    int MyMIN = 10, OpMIN = 10;
-    const Square* wsq = pos.squares<ALL_PIECES>(us);
-    for (Square sq = *wsq; sq != SQ_NONE; sq = *++wsq) {
-      //int scr = yourGoalDist_0(1LL << sq);
-      int scr;
-      if (us == WHITE)
-        scr = yourGoalDist_0(1LL << sq);
-      else
-        scr = myGoalDist_0(1LL << sq);
-      if (MyMIN > scr)
-        MyMIN = scr;
-    }
-    const Square* bsq = pos.squares<ALL_PIECES>(~us);
-    for (Square sq = *bsq; sq != SQ_NONE; sq = *++bsq) {
-      //int scr = yourGoalDist_0(1LL << sq);
-      int scr;
-      if (us == WHITE)
-        scr = yourGoalDist_0(1LL << sq);
-      else
-        scr = myGoalDist_0(1LL << sq);
-      if (OpMIN > scr)
-        OpMIN = scr;
-    }
-    if (MyMIN > OpMIN) {
-      v -= 10000;
+
+    //mm[hŐԂƌ߂Ď͎cĂ̂ƂĐ (ĂɂȂȂ).
+    //Ԃ͎c菭Ȃقǎ̂ȂȂ (Sƕ) ̂, ̓ɂ
+    constexpr int RedMargin[5] = { 0, 2000, 800, 300, 0 };
+    int black = pos.count<ALL_PIECES>(BLACK) + (Search::Limits.chance ? pos.reds_found() : 0);
+    int margin = Search::Limits.chance ? RedMargin[std::clamp(pos.reds_left(), 0, 4)] : 0;
+
+    //NNUE ͔ՏサȂ̂, mm[hŐԂƌ߂Ď̕͏Ɠ
+    if (Eval::useNNUE)
+    {
+        Value bonus = Value(ExistWeight * (black - pos.count<ALL_PIECES>(BLACK)) + margin);
+        return NNUE::evaluate(pos) + (us == WHITE ? -bonus : bonus);
     }
-    //const Square* ksqs = pos.squares<GOAL>(us);
-    //for (int i = 0; i < 2; i++) {
-    //  int ksq_r = (int)rank_of(ksqs[0]);
-    //  int ksq_f = (int)file_of(ksqs[0]);
-    //  int MyMIN = 10, OpMIN = 10;
-    //  for (int f = FILE_B; f <= FILE_G; f++) {
-    //    for (int r = RANK_2; r <= RANK_7; r++) {
-    //      if (pos.piece_on(make_square((File)f, (Rank)r)) == NO_PIECE)
-    //        continue;
-    //      if (color_of(pos.piece_on(make_square((File)f, (Rank)r))) == us) {
-    //        int scr = abs((int)f - ksq_f) + abs((int)r - ksq_r);
-    //        if(MyMIN > scr)
-    //          MyMIN = scr;
-    //      }
-    //      else {
-    //        int scr = abs((int)f - ksq_f) + abs((int)r - ksq_r);
-    //        if(OpMIN > scr)
-    //          OpMIN = scr;
-    //      }
-    //    }
-    //  }
-    //  if (MyMIN > OpMIN) {
-    //    v -= 10000;
-    //  }
-    //}
-    
 
     Value s0 = VALUE_ZERO, s1 = VALUE_ZERO;
     //ԎN
     if (Game_::eval_pattern == 0) {
       s0 = ExistWeight * pos.count<ALL_PIECES>(WHITE) - DistWeight * myGoalDist_1(pos.pieces(WHITE));
-      s1 = ExistWeight * pos.count<ALL_PIECES>(BLACK) - DistWeight * yourGoalDist_1(pos.pieces(BLACK));
+      s1 = ExistWeight * black + margin - DistWeight * yourGoalDist_1(pos.pieces(BLACK));
     }
     else if (Game_::eval_pattern == 1) {
       s0 = /*ExistWeight * pos.count<BLUE>(WHITE)*/ - DistWeight * myGoalDist_1(pos.pieces(WHITE, RED));
       s1 = -DistWeight * yourGoalDist_1(pos.pieces(BLACK));
     }
-    if (us == WHITE) return s0 - s1 + v;
-    else return s1 - s0 + v;
+    if (us == WHITE) return s0 - s1;
+    else return s1 - s0;
   }
 }
 ////]֐. tebanvC[̗LԂ. teban=0c.
@@ -1386,10 +1340,10 @@ namespace {
     const int dy[4] = { -1, 0, 1, 0 };
     const int dx[4] = { 0, 1, 0, -1 };
 
-    int from_y = rank_of(from_sq(mv)) - 1;
-    int to_y = rank_of(to_sq(mv)) - 1;
-    int from_x = file_of(from_sq(mv)) - 1;
-    int to_x = file_of(to_sq(mv)) - 1;
+    int from_y = rank_of(from_sq(mv));
+    int to_y = rank_of(to_sq(mv));
+    int from_x = file_of(from_sq(mv));
+    int to_x = file_of(to_sq(mv));
     if (!is_ok_R(to_sq(mv))) return false;	//Eóuǂvł͂Ȃ
     if (board[to_y][to_x] == 'u') return false;			//́uǂvł͂Ȃ
 
@@ -1415,10 +1369,10 @@ namespace {
   }
 
   void moveHist(char prev[6][6], char now[6][6], Move mv) {
-    int from_y = rank_of(from_sq(mv)) - 1;
-    int from_x = file_of(from_sq(mv)) - 1;
-    int to_y = rank_of(to_sq(mv)) - 1;
-    int to_x = file_of(to_sq(mv)) - 1;
+    int from_y = rank_of(from_sq(mv));
+    int from_x = file_of(from_sq(mv));
+    int to_y = rank_of(to_sq(mv));
+    int to_x = file_of(to_sq(mv));
     int i, j;
 
     for (i = 0; i < 6; i++)
@@ -1430,10 +1384,10 @@ namespace {
     now[from_y][from_x] = '.';
   }
   void moveEval(int prev[6][6], int now[6][6], Move mv) {
-    int from_y = rank_of(from_sq(mv)) - 1;
-    int from_x = file_of(from_sq(mv)) - 1;
-    int to_y = rank_of(to_sq(mv)) - 1;
-    int to_x = file_of(to_sq(mv)) - 1;
+    int from_y = rank_of(from_sq(mv));
+    int from_x = file_of(from_sq(mv));
+    int to_y = rank_of(to_sq(mv));
+    int to_x = file_of(to_sq(mv));
     int i, j;
 
     for (i = 0; i < 6; i++)
@@ -1473,7 +1427,7 @@ namespace {
       nx = posX[0];
     }
 
-    return make_move(make_square((File)(x + 1), (Rank)(y + 1)), make_square((File)(nx + 1), (Rank)(ny + 1)));
+    return make_move(make_square((File)x, (Rank)y), make_square((File)nx, (Rank)ny));
   }
 }
 
@@ -1483,12 +1437,28 @@ namespace Red {
   int eval[350][6][6];	//ԓx
   bool existRed;
   bool bare;
+
+  int weightOikake = 5;
+  int weightOikakePinti = 1;	//肪s`ȂƂA킯킩sȂ̂ŁA̐M߂
+  int weightHairi = 1000;
+  int redThreshold = 1000;
 }
 
+// In a tuning build (make tune=yes) the Geister weights are UCI options of the
+// same names, see tune.h, and the "spsa" command tunes them in self-play games.
+// Changing the default values of ExistWeight and DistWeight changes the bench
+// signature.
+#ifdef TUNING
+TUNE(SetRange(500, 2000), ExistWeight, SetRange(0, 8), DistWeight,
+     SetRange(0, 20), Red::weightOikake, Red::weightOikakePinti,
+     SetRange(0, 2000), Red::weightHairi, Red::redThreshold);
+#endif
+
 //JnɌĂяo
 void Red::init() {
   Red::histCnt = 0;
   Red::bare = 0;
+  Belief::init();
 }
 
 //łƂɌĂяo
@@ -1520,10 +1490,10 @@ void Red::myTurn(char board[6][6], const Position& pos) {
   Move mv = detectMove(Red::hist[Red::histCnt - 2], Red::hist[Red::histCnt - 1]);
   moveEval(Red::eval[Red::histCnt - 2], Red::eval[Red::histCnt - 1], mv);
   Square fsq = from_sq(mv), tsq = to_sq(mv);
-  int from_y = rank_of(fsq) - 1;
-  int to_y = rank_of(tsq) - 1;
-  int from_x = file_of(fsq) - 1;
-  int to_x = file_of(tsq) - 1;
+  int from_y = rank_of(fsq);
+  int to_y = rank_of(tsq);
+  int from_x = file_of(fsq);
+  int to_x = file_of(tsq);
 
   char block_op[6][6];
   int prevMyRed = 0;
@@ -1540,8 +1510,6 @@ void Red::myTurn(char board[6][6], const Position& pos) {
     }
   }
 
-  const int weightOikake = 5;
-  const int weightOikakePinti = 1;	//肪s`ȂƂA킯킩sȂ̂ŁA̐M߂
   if (isOikake(block_op, mv)) {
     if (prevMyRed == 1) {
       Red::eval[Red::histCnt - 1][to_y][to_x] += weightOikakePinti;
@@ -1554,7 +1522,6 @@ void Red::myTurn(char board[6][6], const Position& pos) {
   //肪āAꂪ玩ǂ撣ĂKƂAԂƎv
   //̂ĂB
   //{͂Ɓu葤̕KTvǁAԂȂ̂Ŏ蔲ŁB
-  const int weightHairi = 1000;
   if ((from_y == 5 && from_x == 0) || (from_y == 5 && from_x == 5)) {	//EoȂԂ]
     Red::eval[Red::histCnt - 1][to_y][to_x] += weightHairi;
   }
@@ -1684,9 +1651,69 @@ Square Red::picUpRed(int X) {
     for (j = 0; j < 6; j++) {
       if (Red::eval[Red::histCnt - 1][i][j] >= max_eval) {
         max_eval = Red::eval[Red::histCnt - 1][i][j];
-        resq = make_square((File)(j + 1), (Rank)(i + 1));
+        resq = make_square((File)j, (Rank)i);
       }
     }
   }
   return resq;
-}
\ No newline at end of file
+}
+
+//PIMCp. ̋̐F̉ (Տ̎̂ Game_::rNum ԂɂՖ) 
+//k TvO, Position::set() ɓn镶ŕԂ.
+//MOȂ (bench Ȃ) , ԓx eval 傫قǐԂɑI΂₷.
+//ɐԂƌ߂ (B_RED) ͐Ԃ̂܂.
+std::vector<std::string> Red::samples(const Position& pos, int k) {
+  //MO (belief.h) Ֆʂ̋ǂĂ, 㕪z炻̂܂܈
+  std::vector<std::string> exact = Belief::samples(pos, k);
+  if (!exact.empty())
+    return exact;
+
+  std::string fen = pos.fen();
+  std::vector<size_t> idx;
+  std::vector<double> weight;
+  int fixed = 0;
+
+  for (size_t i = 4; i + 2 < fen.size() && fen[i] != ' '; i += 3) {
+    if (fen[i + 2] == 'u') {
+      int x = fen[i] - '0', y = fen[i + 1] - '0';
+      idx.push_back(i + 2);
+      weight.push_back(1.0 + (Red::histCnt ? std::max(0, Red::eval[Red::histCnt - 1][y][x]) : 0));
+    }
+    else if (fen[i + 2] == 'r')
+      fixed++;
+  }
+
+  //ՏɐԂc悤ɂ (bench Ȃǂ rNum ՖʂƍĂȂ)
+  int need = std::min(std::max(Game_::rNum - fixed, fixed ? 0 : 1), int(idx.size()) - 1);
+  need = std::max(need, 0);
+
+  //S̉ɂȂȂ 1 ŏ\
+  if (need == 0 || need == int(idx.size()))
+    k = 1;
+
+  PRNG rng(pos.key() | 1);
+  std::vector<std::string> result;
+
+  for (int n = 0; n < k; n++) {
+    std::string s = fen;
+    std::vector<double> w = weight;
+    double sum = 0;
+    for (double x : w)
+      sum += x;
+
+    //dݕt̔񕜌o
+    for (int r = 0; r < need; r++) {
+      double t = sum * (rng.rand<uint64_t>() >> 11) * (1.0 / (1ULL << 53));
+      size_t j = 0;
+      while (j + 1 < w.size() && (t -= w[j]) >= 0)
+        j++;
+      while (w[j] == 0)
+        j--;
+      s[idx[j]] = 'r';
+      sum -= w[j];
+      w[j] = 0;
+    }
+    result.push_back(s);
+  }
+  return result;
+}
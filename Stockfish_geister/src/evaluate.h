@@ -56,6 +56,9 @@ namespace Eval {
 #ifndef EVALUATE_H_INCLUDED
 #define EVALUATE_H_INCLUDED
 
+#include <iosfwd>
+#include <string>
+
 #include "types.h"
 
 class Position;
@@ -63,11 +66,20 @@ class Position;
 
 namespace Eval {
 
-  void init();
-
   Value evaluate_K(const Position& pos, int depth);
   Value evaluate_P(const Position& pos, int depth);
 
+  extern bool useNNUE;
+
+  namespace NNUE {
+
+    Value evaluate(const Position& pos);
+    bool load_eval(std::string name, std::istream& stream);
+    void init();
+    void generate(uint64_t seed, const std::string& path);
+
+  } // namespace NNUE
+
 }
 
 #endif // #ifndef EVALUATE_H_INCLUDED
\ No newline at end of file
@@ -16,18 +16,23 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <cassert>
 
 #include "bitboard.h"
+#include "book.h"
 #include "endgame.h"
+#include "escape.h"
+#include "evaluate.h"
 #include "position.h"
 #include "search.h"
 #include "thread.h"
 #include "tt.h"
 #include "uci.h"
+#include "tcp.h"
 #include "syzygy/tbprobe.h"
-#include "evaluate.h"
 
 /*
 namespace PSQT {
@@ -41,26 +46,49 @@ int main(int argc, char* argv[]) {
 
   CommandLine::init(argc, argv);
   UCI::init(Options);
-
-  int n, port; std::string destination;
-  std::cout << "ΐ |[gԍ IPAhX́" << std::endl;
-  std::cin >> n >> port >> destination;
-
   Tune::init();
   //PSQT::init();
   Bitboards::init();
   Position::init();
+  Escape::init();
+  Book::init(Options["Book File"]);
   //Bitbases::init();
   //Endgames::init();
-  //std::cout << size_t(Options["Threads"]) << std::endl;
-  //Threads.set(size_t(Options["Threads"]));
-  Threads.set(1);
+  Threads.set(size_t(Options["Threads"]));
   Search::clear(); // After threads are up
-  //Eval::NNUE::init();
-  Eval::init();
-  
+  Eval::NNUE::init();
+
+  // "uci" on the command line reads UCI commands from stdin, e.g. for a GUI
+  if (argc == 2 && std::string(argv[1]) == "uci")
+  {
+      UCI::loop(1, argv);
+      Threads.set(0);
+      return 0;
+  }
+
+  // Commands given on the command line (e.g. "bench") are run by UCI::loop()
+  if (argc > 1)
+  {
+      UCI::loop(argc, argv);
+      Threads.set(0);
+      return 0;
+  }
+
+  int n, port; std::string destination, token;
+  std::cout << "ΐ |[gԍ IPAhX́" << std::endl;
+
+  //ΐ񐔂̑O "setoption name Threads value 4" ̗lɃIvVݒł
+  while (std::cin >> token && token == "setoption")
+  {
+      std::string line;
+      std::getline(std::cin, line);
+      std::istringstream is(line);
+      UCI::setoption(is);
+  }
+
+  n = std::atoi(token.c_str());
+  std::cin >> port >> destination;
 
-  //UCI::loop(argc, argv);
   tcp::playGame(n, port, destination);
 
   Threads.set(0);
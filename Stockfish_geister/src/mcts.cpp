@@ -0,0 +1,361 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "evaluate.h"
+#include "mcts.h"
+#include "misc.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+#include "uci.h"
+#include "Game_geister.h"
+
+namespace {
+
+  // Number of red/blue assignments drawn at the root. There are at most
+  // C(8,4) = 70 different ones, so this is enough to follow their weights.
+  constexpr int Determinizations = 256;
+
+  // UCB1 exploration constant and the scale of the logistic function that
+  // maps evaluate_K() scores to an expected result. ExistWeight (1000) is one
+  // ghost, worth about an 84% chance to win.
+  constexpr double Exploration = 0.7;
+  constexpr double EvalScale = 600.0;
+
+  MCTS::Node Root;
+  std::vector<std::string> Samples;
+  int PlayoutPlies;
+
+  // result() returns 1 if the side to move has won, 0 if it has lost and -1
+  // if the game goes on. The colours are those of the determinization, where
+  // B_RED is red and B_PURPLE blue: a side loses when its exit was reached or
+  // it has no blue ghost left, and wins when it has no red ghost left.
+  int result(const Position& pos) {
+
+    Color us = pos.side_to_move();
+
+    for (Color c : { us, ~us })
+    {
+        int blue = c == WHITE ? pos.count<BLUE>(WHITE) : pos.count<PURPLE>(BLACK);
+
+        if (pos.count<GOAL>(c) < 2 || blue == 0)
+            return c == us ? 0 : 1;
+
+        if (pos.count<RED>(c) == 0)
+            return c == us ? 1 : 0;
+    }
+    return -1;
+  }
+
+  // leaf_value() returns the expected result for the side to move at a new
+  // leaf. Up to PlayoutPlies random moves are played first, then the position
+  // is scored with evaluate_K(), which is exact about the colours here. The
+  // score is taken relative to 'rootEval' (white's point of view), because
+  // evaluate_K() is not balanced: all our ghosts count but only the blue ones
+  // of the opponent.
+  double leaf_value(Position& pos, StateInfo* st, int ply, PRNG& rng, Value rootEval) {
+
+    Color us = pos.side_to_move();
+
+    for (int i = 0; ; ++i)
+    {
+        int r = result(pos);
+        if (r >= 0)
+            return pos.side_to_move() == us ? r : 1 - r;
+
+        if (i >= PlayoutPlies || ply >= MAX_PLY - 1)
+            break;
+
+        MoveList<LEGAL> moves(pos);
+        if (!moves.size())
+            break;
+
+        pos.do_move(moves.begin()[rng.rand<uint64_t>() % moves.size()], st[++ply]);
+    }
+
+    Value v = Eval::evaluate_K(pos, ply);
+    if (pos.side_to_move() == BLACK)
+        v = -v;
+
+    double p = 1.0 / (1.0 + std::exp(-int(v - rootEval) / EvalScale));
+    return us == WHITE ? p : 1 - p;
+  }
+
+  // expand() returns the child of 'node' for move 'm', adding it if another
+  // thread has not done so in the meantime, or nullptr if the pool is full.
+  MCTS::Node* expand(MCTS::Node* node, Move m, MCTS::NodePool& pool) {
+
+    while (node->lock.test_and_set(std::memory_order_acquire)) {}
+
+    MCTS::Node* c = node->find(m);
+    if (!c)
+    {
+        c = pool.allocate(m);
+        if (c)
+        {
+            c->sibling = node->child.load(std::memory_order_relaxed);
+            node->child.store(c, std::memory_order_release);
+        }
+    }
+
+    node->lock.clear(std::memory_order_release);
+    return c;
+  }
+
+  // to_value() converts an expected result back to a score for the GUI
+  Value to_value(double q) {
+
+    q = std::clamp(q, 0.001, 0.999);
+    return Value(int(EvalScale * std::log(q / (1 - q))));
+  }
+
+} // namespace
+
+
+void MCTS::Node::reset(Move m) {
+
+  move = m;
+  sibling = nullptr;
+  child = nullptr;
+  visits = avail = virtualLoss = 0;
+  reward = 0;
+  lock.clear();
+}
+
+MCTS::Node* MCTS::Node::find(Move m) const {
+
+  for (Node* c = child.load(std::memory_order_acquire); c; c = c->sibling)
+      if (c->move == m)
+          return c;
+
+  return nullptr;
+}
+
+
+/// NodePool::allocate() returns the next unused node, adding a block when the
+/// ones we have are full, or nullptr when the pool has reached its size
+
+MCTS::Node* MCTS::NodePool::allocate(Move m) {
+
+  if (next == BlockSize)
+  {
+      if (block + 1 >= maxBlocks)
+          return nullptr;
+
+      ++block, next = 0;
+  }
+
+  if (block == blocks.size())
+      blocks.emplace_back(new Node[BlockSize]);
+
+  Node* n = &blocks[block][next++];
+  n->reset(m);
+  return n;
+}
+
+
+/// NodePool::clear() empties the pool and sets its size to 'maxNodes' nodes,
+/// at least one block. Blocks beyond the new size are freed.
+
+void MCTS::NodePool::clear(size_t maxNodes) {
+
+  maxBlocks = std::max(maxNodes / BlockSize, size_t(1));
+
+  if (blocks.size() > maxBlocks)
+      blocks.resize(maxBlocks);
+
+  block = next = 0;
+}
+
+
+/// MCTS::start() prepares a new search from 'root': the red/blue assignments
+/// are drawn with Red::samples() and the tree is emptied. The tree may use as
+/// much memory as the "Hash" option, shared evenly by the threads, so that an
+/// infinite or ponder search does not grow it without bound. It is called by
+/// the main thread before the other threads are started.
+
+void MCTS::start(const Position& root) {
+
+  Samples = Red::samples(root, Determinizations);
+  PlayoutPlies = int(Options["ISMCTS Playout"]);
+  Root.reset(MOVE_NONE);
+
+  size_t maxNodes = size_t(Options["Hash"]) * 1024 * 1024 / sizeof(Node) / Threads.size();
+
+  for (Thread* th : Threads)
+  {
+      th->nodePool.clear(maxNodes);
+      th->iterations = 0;
+  }
+}
+
+
+/// MCTS::search() is the information set MCTS loop of one thread. Every
+/// iteration takes one of the sampled assignments, walks down the shared tree
+/// choosing among the moves legal in that assignment with UCB1 (using the
+/// number of times a move was available instead of the parent visits), adds
+/// one node and backs up its value. Once the thread's pool is full the tree
+/// is no longer expanded: the walk goes on through the existing nodes and the
+/// value is taken where it leaves them. A virtual loss on the nodes being
+/// walked makes other threads try different lines meanwhile.
+
+void MCTS::search(Thread* th) {
+
+  StateInfo st[MAX_PLY + 1];
+  Node* path[MAX_PLY + 1];
+  Move untried[MAX_MOVES];
+  Position pos;
+  PRNG rng(uint64_t(now()) ^ uint64_t(uintptr_t(th)) ^ 1);
+  MainThread* mainThread = (th == Threads.main() ? Threads.main() : nullptr);
+
+  // A depth limit is read as 1000 iterations per ply so that 'go depth' and
+  // bench terminate with this backend too.
+  const uint64_t maxIterations = Search::Limits.depth ? 1000 * uint64_t(Search::Limits.depth) : 0;
+
+  while (!Threads.stop.load(std::memory_order_relaxed))
+  {
+      if (mainThread)
+      {
+          mainThread->check_time();
+
+          if (maxIterations && Threads.iterations_searched() >= maxIterations)
+              Threads.stop = true;
+      }
+
+      pos.set(Samples[rng.rand<uint64_t>() % Samples.size()], false, &st[0], th);
+
+      Value rootEval = Eval::evaluate_K(pos, 0);
+      if (pos.side_to_move() == BLACK)
+          rootEval = -rootEval;
+
+      Node* node = path[0] = &Root;
+      int ply = 0;
+      double q; // Result for the side to move at 'ply'
+
+      while (true)
+      {
+          int r = result(pos);
+          if (r >= 0)
+          {
+              q = r;
+              break;
+          }
+
+          if (ply >= MAX_PLY - 1)
+          {
+              q = leaf_value(pos, st, ply, rng, rootEval);
+              break;
+          }
+
+          Node* best = nullptr;
+          double bestScore = -1;
+          int cnt = 0;
+
+          for (const auto& m : MoveList<LEGAL>(pos))
+          {
+              Node* c = node->find(m);
+              if (!c)
+              {
+                  untried[cnt++] = m;
+                  continue;
+              }
+
+              int n = c->visits.load(std::memory_order_relaxed) + c->virtualLoss.load(std::memory_order_relaxed);
+              int a = c->avail.fetch_add(1, std::memory_order_relaxed) + 1;
+              double s = n == 0 ? 1e9
+                                : c->reward.load(std::memory_order_relaxed) / (double(RewardScale) * n)
+                                 + Exploration * std::sqrt(std::log(double(a)) / n);
+              if (s > bestScore)
+                  bestScore = s, best = c;
+          }
+
+          if (!cnt && !best)
+          {
+              q = leaf_value(pos, st, ply, rng, rootEval);
+              break;
+          }
+
+          if (cnt)
+          {
+              Node* c = expand(node, untried[rng.rand<uint64_t>() % cnt], th->nodePool);
+
+              if (c)
+              {
+                  best = c;
+                  best->avail.fetch_add(1, std::memory_order_relaxed);
+              }
+              else if (!best)
+              {
+                  q = leaf_value(pos, st, ply, rng, rootEval);
+                  break;
+              }
+              else
+                  cnt = 0; // The pool is full, go on with the tree as it is
+          }
+
+          best->virtualLoss.fetch_add(1, std::memory_order_relaxed);
+          pos.do_move(best->move, st[++ply]);
+          path[ply] = node = best;
+
+          if (cnt)
+          {
+              q = leaf_value(pos, st, ply, rng, rootEval);
+              break;
+          }
+      }
+
+      // Back up, path[i] was played by the side to move at ply i - 1
+      for (int i = ply; i > 0; --i)
+      {
+          double reward = (ply - i) % 2 == 0 ? 1 - q : q;
+          path[i]->reward.fetch_add(int64_t(reward * RewardScale), std::memory_order_relaxed);
+          path[i]->visits.fetch_add(1, std::memory_order_relaxed);
+          path[i]->virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      Root.visits.fetch_add(1, std::memory_order_relaxed);
+      th->iterations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+
+/// MCTS::update_root_moves() scores the root moves with their average result
+/// and sorts them by visits, the most visited one being the move to play
+
+void MCTS::update_root_moves(Search::RootMoves& rootMoves) {
+
+  auto visits = [](const Search::RootMove& rm) {
+      Node* c = Root.find(rm.pv[0]);
+      return c ? c->visits.load() : 0;
+  };
+
+  for (Search::RootMove& rm : rootMoves)
+  {
+      Node* c = Root.find(rm.pv[0]);
+      rm.pv.resize(1);
+      rm.score = c && c->visits ? to_value(c->reward / (double(RewardScale) * c->visits))
+                                : -VALUE_INFINITE;
+  }
+
+  std::stable_sort(rootMoves.begin(), rootMoves.end(),
+                   [&](const Search::RootMove& a, const Search::RootMove& b) { return visits(a) > visits(b); });
+}
@@ -0,0 +1,85 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MCTS_H_INCLUDED
+#define MCTS_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "search.h"
+#include "types.h"
+
+class Position;
+class Thread;
+
+namespace MCTS {
+
+/// Node is a node of the information set tree. A node stands for the
+/// sequence of observable moves (from and to squares) leading to it, so it is
+/// shared by all the red/blue assignments of the opponent's ghosts in which
+/// those moves are legal. Children are a singly linked list that only grows
+/// during a search: new ones are pushed in front under 'lock' and readers
+/// walk the list without locking. 'reward' is the sum of the results, in
+/// 1/RewardScale units, for the side that played 'move'; 'avail' counts the
+/// iterations in which 'move' was legal at the parent.
+
+constexpr int64_t RewardScale = 1 << 16;
+
+struct Node {
+
+  Move move;
+  Node* sibling;
+  std::atomic<Node*> child;
+  std::atomic<int> visits, avail, virtualLoss;
+  std::atomic<int64_t> reward;
+  std::atomic_flag lock;
+
+  void reset(Move m);
+  Node* find(Move m) const;
+};
+
+
+/// NodePool is a per thread arena for the nodes of the tree. Nodes are handed
+/// out from blocks that are never freed during the search; clear() makes the
+/// whole pool available again in O(1) and keeps the blocks for the next one,
+/// up to 'maxNodes' nodes. Once they are all in use allocate() returns nullptr.
+
+class NodePool {
+
+  static constexpr size_t BlockSize = 4096;
+
+  std::vector<std::unique_ptr<Node[]>> blocks;
+  size_t block = 0, next = 0; // Current block and first unused node in it
+  size_t maxBlocks = 1;
+
+public:
+  Node* allocate(Move m);
+  void clear(size_t maxNodes);
+  size_t size() const { return block * BlockSize + next; }
+};
+
+void start(const Position& root);
+void search(Thread* th);
+void update_root_moves(Search::RootMoves& rootMoves);
+
+} // namespace MCTS
+
+#endif // #ifndef MCTS_H_INCLUDED
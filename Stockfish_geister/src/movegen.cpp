@@ -194,8 +194,8 @@ namespace {
         //        && !(attacks_bb<Pt>(from) & target & pos.check_squares(Pt)))
         //        continue;
 
-            if (pos.blockers_for_king(~Us) & from)
-                continue;
+            //if (pos.blockers_for_king(~Us) & from)
+            //    continue;
         }
 
         Bitboard b = attacks_bb<Pt>(from, pos.pieces()) & target;
@@ -310,22 +310,22 @@ ExtMove* generate<QUIET_CHECKS>(const Position& pos, ExtMove* moveList) {
   assert(!pos.checkers());
 
   Color us = pos.side_to_move();
+  //J͂Ȃ̂ŁAڃS[_肾𐶐
   //Bitboard dc = pos.blockers_for_king(~us) & pos.pieces(us) & ~pos.pieces(PAWN);
-  Bitboard dc = pos.blockers_for_king(~us) & pos.pieces(us);
-
-  while (dc)
-  {
-     Square from = pop_lsb(&dc);
-     PieceType pt = type_of(pos.piece_on(from));
-
-     Bitboard b = attacks_bb(pt, from, pos.pieces()) & ~pos.pieces();
-
-     //if (pt == KING)
-     //    b &= ~attacks_bb<QUEEN>(pos.square<KING>(~us));
-
-     while (b)
-         *moveList++ = make_move(from, pop_lsb(&b));
-  }
+  //
+  //while (dc)
+  //{
+  //   Square from = pop_lsb(&dc);
+  //   PieceType pt = type_of(pos.piece_on(from));
+  //
+  //   Bitboard b = attacks_bb(pt, from, pos.pieces()) & ~pos.pieces();
+  //
+  //   //if (pt == KING)
+  //   //    b &= ~attacks_bb<QUEEN>(pos.square<KING>(~us));
+  //
+  //   while (b)
+  //       *moveList++ = make_move(from, pop_lsb(&b));
+  //}
 
   return us == WHITE ? generate_all<WHITE, QUIET_CHECKS>(pos, moveList)
                      : generate_all<BLACK, QUIET_CHECKS>(pos, moveList);
@@ -380,7 +380,7 @@ template<>
 ExtMove* generate<LEGAL>(const Position& pos, ExtMove* moveList) {
 
   Color us = pos.side_to_move();
-  Bitboard pinned = pos.blockers_for_king(us) & pos.pieces(us);
+  //Bitboard pinned = pos.blockers_for_king(us) & pos.pieces(us);
   //Square ksq = pos.square<KING>(us);
   const Square* ksqs = pos.squares<GOAL>(us);
 
@@ -396,10 +396,10 @@ ExtMove* generate<LEGAL>(const Position& pos, ExtMove* moveList) {
       ++cur;
       continue;
     }
-    if (pinned) {
-      *cur = (--moveList)->move;
-      continue;
-    }
+    //if (pinned) {
+    //  *cur = (--moveList)->move;
+    //  continue;
+    //}
     for (ksq = *ksqs; ksq != SQ_NONE; ksq = *++ksqs) {
       if (from_sq(*cur) == ksq) {
         *cur = (--moveList)->move;
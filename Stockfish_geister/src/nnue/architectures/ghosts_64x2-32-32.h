@@ -18,11 +18,11 @@
 
 // Definition of input features and network structure used in NNUE evaluation function
 
-#ifndef NNUE_HALFKP_256X2_32_32_H_INCLUDED
-#define NNUE_HALFKP_256X2_32_32_H_INCLUDED
+#ifndef NNUE_GHOSTS_64X2_32_32_H_INCLUDED
+#define NNUE_GHOSTS_64X2_32_32_H_INCLUDED
 
 #include "../features/feature_set.h"
-#include "../features/half_kp.h"
+#include "../features/ghosts.h"
 
 #include "../layers/input_slice.h"
 #include "../layers/affine_transform.h"
@@ -31,11 +31,12 @@
 namespace Eval::NNUE {
 
 // Input features used in evaluation function
-using RawFeatures = Features::FeatureSet<
-    Features::HalfKP<Features::Side::kFriend>>;
+using RawFeatures = Features::FeatureSet<Features::Ghosts>;
 
-// Number of input feature dimensions after conversion
-constexpr IndexType kTransformedFeatureDimensions = 256;
+// Number of input feature dimensions after conversion. At most 16 of the 216
+// features are active, a quarter of the HalfKP width is enough and keeps the
+// first affine layer, most of the evaluation time, cheap.
+constexpr IndexType kTransformedFeatureDimensions = 64;
 
 namespace Layers {
 
@@ -51,4 +52,4 @@ using Network = Layers::OutputLayer;
 
 }  // namespace Eval::NNUE
 
-#endif // #ifndef NNUE_HALFKP_256X2_32_32_H_INCLUDED
+#endif // #ifndef NNUE_GHOSTS_64X2_32_32_H_INCLUDED
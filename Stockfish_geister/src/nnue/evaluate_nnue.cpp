@@ -18,8 +18,8 @@
 
 // Code for calculating NNUE evaluation function
 
+#include <fstream>
 #include <iostream>
-#include <set>
 
 #include "../evaluate.h"
 #include "../position.h"
@@ -28,26 +28,32 @@
 
 #include "evaluate_nnue.h"
 
+namespace Eval {
+
+  bool useNNUE;
+
+}
+
 namespace Eval::NNUE {
 
   const uint32_t kpp_board_index[PIECE_NB][COLOR_NB] = {
    // convention: W - us, B - them
    // viewed from other side, W and B are reversed
       { PS_NONE,     PS_NONE     },
-      { PS_W_PAWN,   PS_B_PAWN   },
-      { PS_W_KNIGHT, PS_B_KNIGHT },
-      { PS_W_BISHOP, PS_B_BISHOP },
-      { PS_W_ROOK,   PS_B_ROOK   },
-      { PS_W_QUEEN,  PS_B_QUEEN  },
-      { PS_W_KING,   PS_B_KING   },
+      { PS_W_BLUE,   PS_B_BLUE   },
+      { PS_W_RED,    PS_B_RED    },
+      { PS_W_PURPLE, PS_B_PURPLE },
+      { PS_NONE,     PS_NONE     },
+      { PS_NONE,     PS_NONE     },
+      { PS_NONE,     PS_NONE     },
+      { PS_NONE,     PS_NONE     },
+      { PS_NONE,     PS_NONE     },
+      { PS_B_BLUE,   PS_W_BLUE   },
+      { PS_B_RED,    PS_W_RED    },
+      { PS_B_PURPLE, PS_W_PURPLE },
+      { PS_NONE,     PS_NONE     },
       { PS_NONE,     PS_NONE     },
       { PS_NONE,     PS_NONE     },
-      { PS_B_PAWN,   PS_W_PAWN   },
-      { PS_B_KNIGHT, PS_W_KNIGHT },
-      { PS_B_BISHOP, PS_W_BISHOP },
-      { PS_B_ROOK,   PS_W_ROOK   },
-      { PS_B_QUEEN,  PS_W_QUEEN  },
-      { PS_B_KING,   PS_W_KING   },
       { PS_NONE,     PS_NONE     }
   };
 
@@ -88,6 +94,40 @@ namespace Eval::NNUE {
     return reference.ReadParameters(stream);
   }
 
+  // Write random parameters of a layer and of the layers below it, in the
+  // order ReadParameters() reads them. The weights are small, so that the
+  // activations of a random network are not all clipped.
+  template <typename Layer>
+  struct RandomParameters;
+
+  template <IndexType OutputDimensions, IndexType Offset>
+  struct RandomParameters<Layers::InputSlice<OutputDimensions, Offset>> {
+    static void Write(std::ostream&, PRNG&) {}
+  };
+
+  template <typename PreviousLayer>
+  struct RandomParameters<Layers::ClippedReLU<PreviousLayer>> {
+    static void Write(std::ostream& stream, PRNG& rng) {
+      RandomParameters<PreviousLayer>::Write(stream, rng);
+    }
+  };
+
+  template <typename PreviousLayer, IndexType OutputDimensions>
+  struct RandomParameters<Layers::AffineTransform<PreviousLayer, OutputDimensions>> {
+    static void Write(std::ostream& stream, PRNG& rng) {
+
+      using Layer = Layers::AffineTransform<PreviousLayer, OutputDimensions>;
+
+      RandomParameters<PreviousLayer>::Write(stream, rng);
+      for (IndexType i = 0; i < OutputDimensions; ++i)
+        write_little_endian<std::int32_t>(stream, int(rng.rand<unsigned>() % 2048) - 1024);
+      for (IndexType i = 0; i < OutputDimensions; ++i)
+        for (IndexType j = 0; j < Layer::kPaddedInputDimensions; ++j)
+          write_little_endian<std::int8_t>(stream,
+              j < Layer::kInputDimensions ? std::int8_t(int(rng.rand<unsigned>() % 33) - 16) : 0);
+    }
+  };
+
   }  // namespace Detail
 
   // Initialize the evaluation function parameters
@@ -143,4 +183,68 @@ namespace Eval::NNUE {
     return ReadParameters(stream);
   }
 
+  /// NNUE::init() loads the network of the EvalFile option when "Use NNUE" is
+  /// set, from the working directory or the engine directory. Without a net
+  /// there is no NNUE evaluation, so the engine falls back to the classical
+  /// one instead of exiting: there is no default net to download.
+
+  void init() {
+
+    useNNUE = false;
+
+    if (!Options["Use NNUE"])
+        return;
+
+    std::string eval_file = Options["EvalFile"];
+
+    for (const std::string& directory : { std::string(), CommandLine::binaryDirectory })
+    {
+        std::ifstream stream(directory + eval_file, std::ios::binary);
+
+        if (stream && load_eval(eval_file, stream))
+        {
+            useNNUE = true;
+            break;
+        }
+    }
+
+    if (useNNUE)
+        sync_cout << "info string NNUE evaluation using " << eval_file << " enabled" << sync_endl;
+    else
+        sync_cout << "info string Could not load NNUE network " << eval_file
+                  << ", classical evaluation enabled" << sync_endl;
+  }
+
+  /// NNUE::generate() writes a network with random parameters drawn from
+  /// 'seed' to 'path', in the format load_eval() reads. It is a starting
+  /// point for the trainer and a net for testing the evaluation code.
+
+  void generate(uint64_t seed, const std::string& path) {
+
+    PRNG rng(seed);
+    std::ofstream stream(path, std::ios::binary);
+    std::string architecture = std::string("Features=") + Features::Ghosts::kName
+                              + "[" + std::to_string(RawFeatures::kDimensions) + "->"
+                              + std::to_string(kTransformedFeatureDimensions) + "x2],random";
+
+    write_little_endian<std::uint32_t>(stream, kVersion);
+    write_little_endian<std::uint32_t>(stream, kHashValue);
+    write_little_endian<std::uint32_t>(stream, std::uint32_t(architecture.size()));
+    stream.write(architecture.data(), architecture.size());
+
+    write_little_endian<std::uint32_t>(stream, FeatureTransformer::GetHashValue());
+    for (IndexType i = 0; i < kTransformedFeatureDimensions; ++i)
+        write_little_endian<std::int16_t>(stream, std::int16_t(rng.rand<unsigned>() % 64));
+    for (IndexType i = 0; i < kTransformedFeatureDimensions * RawFeatures::kDimensions; ++i)
+        write_little_endian<std::int16_t>(stream, std::int16_t(int(rng.rand<unsigned>() % 33) - 16));
+
+    write_little_endian<std::uint32_t>(stream, Network::GetHashValue());
+    Detail::RandomParameters<Network>::Write(stream, rng);
+
+    if (!stream)
+        std::cerr << "Could not write network " << path << std::endl;
+    else
+        std::cerr << "Network file   : " << path << std::endl;
+  }
+
 } // namespace Eval::NNUE
@@ -55,77 +55,33 @@ namespace Eval::NNUE::Features {
       }
     }
 
-    // Get a list of indices for recently changed features
+    // Get a list of indices for recently changed features: those of the last
+    // move, and of the move before when its accumulator was not computed either
     template <typename PositionType, typename IndexListType>
     static void AppendChangedIndices(
         const PositionType& pos, TriggerEvent trigger,
         IndexListType removed[2], IndexListType added[2], bool reset[2]) {
 
-      auto collect_for_one = [&](const DirtyPiece& dp) {
-        for (Color perspective : { WHITE, BLACK }) {
-          switch (trigger) {
-            case TriggerEvent::kFriendKingMoved:
-              reset[perspective] = dp.piece[0] == make_piece(perspective, GOAL);
-              break;
-            default:
-              assert(false);
-              break;
-          }
-          if (reset[perspective]) {
-            Derived::CollectActiveIndices(
-                pos, trigger, perspective, &added[perspective]);
-          } else {
-            Derived::CollectChangedIndices(
-                pos, dp, trigger, perspective,
-                &removed[perspective], &added[perspective]);
-          }
-        }
-      };
-
-      auto collect_for_two = [&](const DirtyPiece& dp1, const DirtyPiece& dp2) {
+      auto collect = [&](const DirtyPiece& dp) {
         for (Color perspective : { WHITE, BLACK }) {
           switch (trigger) {
-            case TriggerEvent::kFriendKingMoved:
-              reset[perspective] = dp1.piece[0] == make_piece(perspective, GOAL)
-                                || dp2.piece[0] == make_piece(perspective, GOAL);
+            case TriggerEvent::kNone:
+              reset[perspective] = false;
               break;
             default:
               assert(false);
               break;
           }
-          if (reset[perspective]) {
-            Derived::CollectActiveIndices(
-                pos, trigger, perspective, &added[perspective]);
-          } else {
-            Derived::CollectChangedIndices(
-                pos, dp1, trigger, perspective,
-                &removed[perspective], &added[perspective]);
-            Derived::CollectChangedIndices(
-                pos, dp2, trigger, perspective,
-                &removed[perspective], &added[perspective]);
-          }
+          Derived::CollectChangedIndices(
+              pos, dp, trigger, perspective,
+              &removed[perspective], &added[perspective]);
         }
       };
 
-      if (pos.state()->previous->accumulator.computed_accumulation) {
-        const auto& prev_dp = pos.state()->dirtyPiece;
-        if (prev_dp.dirty_num == 0) return;
-        collect_for_one(prev_dp);
-      } else {
-        const auto& prev_dp = pos.state()->previous->dirtyPiece;
-        if (prev_dp.dirty_num == 0) {
-          const auto& prev2_dp = pos.state()->dirtyPiece;
-          if (prev2_dp.dirty_num == 0) return;
-          collect_for_one(prev2_dp);
-        } else {
-          const auto& prev2_dp = pos.state()->dirtyPiece;
-          if (prev2_dp.dirty_num == 0) {
-            collect_for_one(prev_dp);
-          } else {
-            collect_for_two(prev_dp, prev2_dp);
-          }
-        }
-      }
+      const auto accumulator = pos.accumulator();
+      if (!accumulator[-1].computed_accumulation)
+        collect(accumulator[-1].dirtyPiece);
+      collect(accumulator->dirtyPiece);
     }
   };
 
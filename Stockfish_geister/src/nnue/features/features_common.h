@@ -33,11 +33,7 @@ namespace Eval::NNUE::Features {
 
   // Trigger to perform full calculations instead of difference only
   enum class TriggerEvent {
-    kFriendKingMoved // calculate full evaluation when own king moves
-  };
-
-  enum class Side {
-    kFriend // side to move
+    kNone // the features do not depend on a king square, never refresh
   };
 
 }  // namespace Eval::NNUE::Features
@@ -0,0 +1,63 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//Definition of input features Ghosts of NNUE evaluation function
+
+#include "ghosts.h"
+#include "index_list.h"
+
+namespace Eval::NNUE::Features {
+
+  // Orient a square according to perspective (flips the ranks for black)
+  inline Square orient(Color perspective, Square s) {
+    return perspective == WHITE ? s : flip_rank(s);
+  }
+
+  // Index of a feature for a given piece on some square
+  inline IndexType Ghosts::MakeIndex(Color perspective, Square s, Piece pc) {
+    return IndexType(orient(perspective, s) + kpp_board_index[pc][perspective]);
+  }
+
+  // Get a list of indices for active features
+  void Ghosts::AppendActiveIndices(
+      const Position& pos, Color perspective, IndexList* active) {
+
+    Bitboard bb = pos.pieces() & ~pos.pieces(GOAL) & BoardBB;
+    while (bb) {
+      Square s = pop_lsb(&bb);
+      active->push_back(MakeIndex(perspective, s, pos.piece_on(s)));
+    }
+  }
+
+  // Get a list of indices for recently changed features. A ghost that escapes
+  // moves off the board, onto a goal.
+  void Ghosts::AppendChangedIndices(
+      const Position& /*pos*/, const DirtyPiece& dp, Color perspective,
+      IndexList* removed, IndexList* added) {
+
+    for (int i = 0; i < dp.dirty_num; ++i) {
+      Piece pc = dp.piece[i];
+      if (type_of(pc) == GOAL) continue;
+      if (is_ok_R(dp.from[i]))
+        removed->push_back(MakeIndex(perspective, dp.from[i], pc));
+      if (is_ok_R(dp.to[i]))
+        added->push_back(MakeIndex(perspective, dp.to[i], pc));
+    }
+  }
+
+}  // namespace Eval::NNUE::Features
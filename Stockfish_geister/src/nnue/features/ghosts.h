@@ -16,34 +16,36 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-//Definition of input features HalfKP of NNUE evaluation function
+//Definition of input features Ghosts of NNUE evaluation function
 
-#ifndef NNUE_FEATURES_HALF_KP_H_INCLUDED
-#define NNUE_FEATURES_HALF_KP_H_INCLUDED
+#ifndef NNUE_FEATURES_GHOSTS_H_INCLUDED
+#define NNUE_FEATURES_GHOSTS_H_INCLUDED
 
 #include "../../evaluate.h"
 #include "features_common.h"
 
 namespace Eval::NNUE::Features {
 
-  // Feature HalfKP: Combination of the position of own king
-  // and the position of pieces other than kings
-  template <Side AssociatedKing>
-  class HalfKP {
+  // Feature Ghosts: the kind of each ghost on the board and its square, from
+  // the point of view of each side. The kinds are our blues, reds and unknown
+  // ghosts and their blues, reds and unknown ghosts, so the opponent's ghosts
+  // known red (or blue) have their own features. The squares are seen from
+  // the side, its exits always on the same rank, so that the goal distance of
+  // a ghost is a function of its feature. The side to move is given by the
+  // order of the two halves of the transformed features.
+  class Ghosts {
 
    public:
     // Feature name
-    static constexpr const char* kName = "HalfKP(Friend)";
+    static constexpr const char* kName = "Ghosts";
     // Hash value embedded in the evaluation file
-    static constexpr std::uint32_t kHashValue =
-        0x5D69D5B9u ^ (AssociatedKing == Side::kFriend);
+    static constexpr std::uint32_t kHashValue = 0x47485354u;
     // Number of feature dimensions
-    static constexpr IndexType kDimensions =
-        static_cast<IndexType>(SQUARE_NB) * static_cast<IndexType>(PS_END);
+    static constexpr IndexType kDimensions = PS_END;
     // Maximum number of simultaneously active features
-    static constexpr IndexType kMaxActiveDimensions = 30; // Kings don't count
+    static constexpr IndexType kMaxActiveDimensions = 16;
     // Trigger for full calculation instead of difference calculation
-    static constexpr TriggerEvent kRefreshTrigger = TriggerEvent::kFriendKingMoved;
+    static constexpr TriggerEvent kRefreshTrigger = TriggerEvent::kNone;
 
     // Get a list of indices for active features
     static void AppendActiveIndices(const Position& pos, Color perspective,
@@ -54,10 +56,10 @@ namespace Eval::NNUE::Features {
                                      IndexList* removed, IndexList* added);
 
    private:
-    // Index of a feature for a given king position and another piece on some square
-    static IndexType MakeIndex(Color perspective, Square s, Piece pc, Square sq_k);
+    // Index of a feature for a given piece on some square
+    static IndexType MakeIndex(Color perspective, Square s, Piece pc);
   };
 
 }  // namespace Eval::NNUE::Features
 
-#endif // #ifndef NNUE_FEATURES_HALF_KP_H_INCLUDED
+#endif // #ifndef NNUE_FEATURES_GHOSTS_H_INCLUDED
@@ -25,13 +25,21 @@
 
 namespace Eval::NNUE {
 
-  // Class that holds the result of affine transformation of input features
+  // Class that holds the result of affine transformation of input features,
+  // and what the move that led to the position changed on the board
   struct alignas(kCacheLineSize) Accumulator {
     std::int16_t
         accumulation[2][kRefreshTriggers.size()][kTransformedFeatureDimensions];
+    DirtyPiece dirtyPiece;
     bool computed_accumulation;
   };
 
+  // The accumulators of a search are kept in a stack owned by the thread, one
+  // per ply, instead of in StateInfo (see Position::attach()). The first two
+  // entries are never computed, so that looking back from the root always
+  // ends in a refresh.
+  constexpr int kAccumulatorStackSize = MAX_PLY + 12;
+
 }  // namespace Eval::NNUE
 
 #endif // NNUE_ACCUMULATOR_H_INCLUDED
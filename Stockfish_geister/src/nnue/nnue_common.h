@@ -94,23 +94,20 @@ namespace Eval::NNUE {
 
   constexpr std::size_t kMaxSimdWidth = 32;
 
-  // unique number for each piece type on each square
+  // Number of squares a ghost can stand on. The goals outside the board are
+  // never part of the features.
+  constexpr std::uint32_t kBoardSquares = SQ_F6 + 1;
+
+  // unique number for each ghost kind on each square, W - us, B - them
   enum {
-    PS_NONE     =  0,
-    PS_W_PAWN   =  1,
-    PS_B_PAWN   =  1 * SQUARE_NB + 1,
-    PS_W_KNIGHT =  2 * SQUARE_NB + 1,
-    PS_B_KNIGHT =  3 * SQUARE_NB + 1,
-    PS_W_BISHOP =  4 * SQUARE_NB + 1,
-    PS_B_BISHOP =  5 * SQUARE_NB + 1,
-    PS_W_ROOK   =  6 * SQUARE_NB + 1,
-    PS_B_ROOK   =  7 * SQUARE_NB + 1,
-    PS_W_QUEEN  =  8 * SQUARE_NB + 1,
-    PS_B_QUEEN  =  9 * SQUARE_NB + 1,
-    PS_W_KING   = 10 * SQUARE_NB + 1,
-    PS_END      = PS_W_KING, // pieces without kings (pawns included)
-    PS_B_KING   = 11 * SQUARE_NB + 1,
-    PS_END2     = 12 * SQUARE_NB + 1
+    PS_W_BLUE   = 0,
+    PS_W_RED    = 1 * kBoardSquares,
+    PS_W_PURPLE = 2 * kBoardSquares,
+    PS_B_BLUE   = 3 * kBoardSquares,
+    PS_B_RED    = 4 * kBoardSquares,
+    PS_B_PURPLE = 5 * kBoardSquares,
+    PS_END      = 6 * kBoardSquares,
+    PS_NONE     = PS_END // Goals, not a feature
   };
 
   extern const uint32_t kpp_board_index[PIECE_NB][COLOR_NB];
@@ -143,6 +140,20 @@ namespace Eval::NNUE {
       return result;
   }
 
+  // write_little_endian() is the inverse of read_little_endian(), it writes an
+  // integer to a stream in little-endian order whatever the machine order.
+  template <typename IntType>
+  inline void write_little_endian(std::ostream& stream, IntType value) {
+
+      std::uint8_t u[sizeof(IntType)];
+      typename std::make_unsigned<IntType>::type v = value;
+
+      for (std::size_t i = 0; i < sizeof(IntType); ++i, v >>= 8)
+          u[i] = std::uint8_t(v);
+
+      stream.write(reinterpret_cast<char*>(u), sizeof(IntType));
+  }
+
 }  // namespace Eval::NNUE
 
 #endif // #ifndef NNUE_COMMON_H_INCLUDED
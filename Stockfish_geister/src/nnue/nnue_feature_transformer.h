@@ -23,8 +23,10 @@
 
 #include "nnue_common.h"
 #include "nnue_architecture.h"
+#include "nnue_accumulator.h"
 #include "features/index_list.h"
 
+#include <algorithm> // std::min()
 #include <cstring> // std::memset()
 
 namespace Eval::NNUE {
@@ -87,7 +89,10 @@ namespace Eval::NNUE {
     static constexpr IndexType kHalfDimensions = kTransformedFeatureDimensions;
 
     #ifdef TILING
-    static constexpr IndexType kTileHeight = kNumRegs * sizeof(vec_t) / 2;
+    // A tile is at most all the transformed features of one side
+    static constexpr IndexType kTileHeight =
+        std::min<IndexType>(kNumRegs * sizeof(vec_t) / 2, kHalfDimensions);
+    static constexpr IndexType kTileRegs = kTileHeight * 2 / sizeof(vec_t);
     static_assert(kHalfDimensions % kTileHeight == 0, "kTileHeight must divide kHalfDimensions");
     #endif
 
@@ -122,31 +127,42 @@ namespace Eval::NNUE {
     // Proceed with the difference calculation if possible
     bool UpdateAccumulatorIfPossible(const Position& pos) const {
 
-      const auto now = pos.state();
-      if (now->accumulator.computed_accumulation)
+      const auto accumulator = pos.accumulator();
+      if (accumulator->computed_accumulation)
         return true;
 
-      const auto prev = now->previous;
-      if (prev) {
-        if (prev->accumulator.computed_accumulation) {
-          UpdateAccumulator(pos);
-          return true;
-        } else if (prev->previous && prev->previous->accumulator.computed_accumulation) {
-          UpdateAccumulator(pos);
-          return true;
-        }
+      if (   accumulator[-1].computed_accumulation
+          || accumulator[-2].computed_accumulation) {
+        UpdateAccumulator(pos);
+        return true;
       }
 
       return false;
     }
 
-    // Convert input features
+    // Convert input features. A position without an accumulator stack (not
+    // the root of a search) is computed from scratch.
     void Transform(const Position& pos, OutputType* output) const {
 
-      if (!UpdateAccumulatorIfPossible(pos))
-        RefreshAccumulator(pos);
+      Accumulator scratch;
+      Accumulator* accumulator = pos.accumulator();
+
+      if (!accumulator)
+        RefreshAccumulator(pos, *(accumulator = &scratch));
+
+      else if (!UpdateAccumulatorIfPossible(pos))
+        RefreshAccumulator(pos, *accumulator);
 
-      const auto& accumulation = pos.state()->accumulator.accumulation;
+  #ifndef NDEBUG
+      // The differences must add up to the features of the position
+      if (accumulator != &scratch) {
+        RefreshAccumulator(pos, scratch);
+        assert(!std::memcmp(scratch.accumulation, accumulator->accumulation,
+                            sizeof(scratch.accumulation)));
+      }
+  #endif
+
+      const auto& accumulation = accumulator->accumulation;
 
   #if defined(USE_AVX2)
       constexpr IndexType kNumChunks = kHalfDimensions / kSimdWidth;
@@ -241,9 +257,8 @@ namespace Eval::NNUE {
 
    private:
     // Calculate cumulative value without using difference calculation
-    void RefreshAccumulator(const Position& pos) const {
+    void RefreshAccumulator(const Position& pos, Accumulator& accumulator) const {
 
-      auto& accumulator = pos.state()->accumulator;
       IndexType i = 0;
       Features::IndexList active_indices[2];
       RawFeatures::AppendActiveIndices(pos, kRefreshTriggers[i],
@@ -255,20 +270,20 @@ namespace Eval::NNUE {
               &biases_[j * kTileHeight]);
           auto accTile = reinterpret_cast<vec_t*>(
               &accumulator.accumulation[perspective][i][j * kTileHeight]);
-          vec_t acc[kNumRegs];
+          vec_t acc[kTileRegs];
 
-          for (unsigned k = 0; k < kNumRegs; ++k)
+          for (unsigned k = 0; k < kTileRegs; ++k)
             acc[k] = biasesTile[k];
 
           for (const auto index : active_indices[perspective]) {
             const IndexType offset = kHalfDimensions * index + j * kTileHeight;
             auto column = reinterpret_cast<const vec_t*>(&weights_[offset]);
 
-            for (unsigned k = 0; k < kNumRegs; ++k)
+            for (unsigned k = 0; k < kTileRegs; ++k)
               acc[k] = vec_add_16(acc[k], column[k]);
           }
 
-          for (unsigned k = 0; k < kNumRegs; k++)
+          for (unsigned k = 0; k < kTileRegs; k++)
             vec_store(&accTile[k], acc[k]);
         }
   #else
@@ -294,18 +309,13 @@ namespace Eval::NNUE {
     // Calculate cumulative value using difference calculation
     void UpdateAccumulator(const Position& pos) const {
 
-      Accumulator* prev_accumulator;
-      assert(pos.state()->previous);
-      if (pos.state()->previous->accumulator.computed_accumulation) {
-        prev_accumulator = &pos.state()->previous->accumulator;
-      }
-      else {
-        assert(pos.state()->previous->previous);
-        assert(pos.state()->previous->previous->accumulator.computed_accumulation);
-        prev_accumulator = &pos.state()->previous->previous->accumulator;
+      Accumulator* prev_accumulator = pos.accumulator() - 1;
+      if (!prev_accumulator->computed_accumulation) {
+        --prev_accumulator;
+        assert(prev_accumulator->computed_accumulation);
       }
 
-      auto& accumulator = pos.state()->accumulator;
+      auto& accumulator = *pos.accumulator();
       IndexType i = 0;
       Features::IndexList removed_indices[2], added_indices[2];
       bool reset[2] = { false, false };
@@ -317,17 +327,17 @@ namespace Eval::NNUE {
         for (Color perspective : { WHITE, BLACK }) {
           auto accTile = reinterpret_cast<vec_t*>(
               &accumulator.accumulation[perspective][i][j * kTileHeight]);
-          vec_t acc[kNumRegs];
+          vec_t acc[kTileRegs];
 
           if (reset[perspective]) {
             auto biasesTile = reinterpret_cast<const vec_t*>(
                 &biases_[j * kTileHeight]);
-            for (unsigned k = 0; k < kNumRegs; ++k)
+            for (unsigned k = 0; k < kTileRegs; ++k)
               acc[k] = biasesTile[k];
           } else {
             auto prevAccTile = reinterpret_cast<const vec_t*>(
                 &prev_accumulator->accumulation[perspective][i][j * kTileHeight]);
-            for (IndexType k = 0; k < kNumRegs; ++k)
+            for (IndexType k = 0; k < kTileRegs; ++k)
               acc[k] = vec_load(&prevAccTile[k]);
 
             // Difference calculation for the deactivated features
@@ -335,7 +345,7 @@ namespace Eval::NNUE {
               const IndexType offset = kHalfDimensions * index + j * kTileHeight;
               auto column = reinterpret_cast<const vec_t*>(&weights_[offset]);
 
-              for (IndexType k = 0; k < kNumRegs; ++k)
+              for (IndexType k = 0; k < kTileRegs; ++k)
                 acc[k] = vec_sub_16(acc[k], column[k]);
             }
           }
@@ -344,12 +354,12 @@ namespace Eval::NNUE {
               const IndexType offset = kHalfDimensions * index + j * kTileHeight;
               auto column = reinterpret_cast<const vec_t*>(&weights_[offset]);
 
-              for (IndexType k = 0; k < kNumRegs; ++k)
+              for (IndexType k = 0; k < kTileRegs; ++k)
                 acc[k] = vec_add_16(acc[k], column[k]);
             }
           }
 
-          for (IndexType k = 0; k < kNumRegs; ++k)
+          for (IndexType k = 0; k < kTileRegs; ++k)
             vec_store(&accTile[k], acc[k]);
         }
       }
@@ -21,11 +21,13 @@
 #include <cstddef> // For offsetof()
 #include <cstring> // For std::memset, std::memcmp
 #include <iomanip>
+#include <iostream>
 #include <sstream>
 
 #include "bitboard.h"
 #include "misc.h"
 #include "movegen.h"
+#include "nnue/nnue_accumulator.h"
 #include "position.h"
 #include "thread.h"
 #include "tt.h"
@@ -40,6 +42,7 @@ namespace Zobrist {
   //Key enpassant[FILE_NB];
   //Key castling[CASTLING_RIGHT_NB];
   Key side, noPawns;
+  Key chance[2][16]; // [red][number of ghosts of that colour already found]
 }
 
 namespace {
@@ -57,17 +60,23 @@ constexpr Piece Pieces[] = { W_BLUE, W_RED, W_PURPLE, W_GOAL,
 
 std::ostream& operator<<(std::ostream& os, const Position& pos) {
 
-  os << "\n +---+---+---+---+---+---+---+---+\n";
+  os << "\n +---+---+---+---+---+---+\n";
 
-  for (Rank r = RANK_8; r >= RANK_1; --r)
+  for (Rank r = RANK_7; r >= RANK_0; --r)
   {
-      for (File f = FILE_A; f <= FILE_H; ++f)
-          os << " | " << PieceToChar[pos.piece_on(make_square(f, r))];
+      for (File f = FILE_A; f <= FILE_F; ++f)
+      {
+          Square sq = make_square(f, r);
+          if (is_ok(sq))
+              os << " | " << PieceToChar[pos.piece_on(sq)];
+          else
+              os << "    ";
+      }
 
-      os << " | " << (1 + r) << "\n +---+---+---+---+---+---+---+---+\n";
+      os << " | " << (1 + r) << "\n +---+---+---+---+---+---+\n";
   }
 
-  os << "   a   b   c   d   e   f   g   h\n"
+  os << "   a   b   c   d   e   f\n"
      << "\nFen: " << pos.fen() << "\nKey: " << std::hex << std::uppercase
      << std::setfill('0') << std::setw(16) << pos.key()
      << std::setfill(' ') << std::dec << "\nCheckers: ";
@@ -75,7 +84,7 @@ std::ostream& operator<<(std::ostream& os, const Position& pos) {
   for (Bitboard b = pos.checkers(); b; )
       os << UCI::square(pop_lsb(&b)) << " ";
 
-  if (    int(Tablebases::MaxCardinality) >= popcount(pos.pieces())
+  if (    int(Tablebases::MaxCardinality) >= popcount(pos.pieces()) - pos.count<GOAL>()
       )//&& !pos.can_castle(ANY_CASTLING))
   {
       StateInfo st;
@@ -114,7 +123,7 @@ void Position::init() {
   PRNG rng(1070372);
 
   for (Piece pc : Pieces)
-      for (Square s = SQ_A1; s <= SQ_H8; ++s)
+      for (Square s = SQ_A1; s <= SQ_F7; ++s)
           Zobrist::psq[pc][s] = rng.rand<Key>();
 
   /*
@@ -129,16 +138,17 @@ void Position::init() {
   Zobrist::side = rng.rand<Key>();
   Zobrist::noPawns = rng.rand<Key>();
 
+  for (int red = 0; red < 2; ++red)
+      for (int n = 0; n < 16; ++n)
+          Zobrist::chance[red][n] = rng.rand<Key>();
+
   // Prepare the cuckoo tables
   std::memset(cuckoo, 0, sizeof(cuckoo));
   std::memset(cuckooMove, 0, sizeof(cuckooMove));
   int count = 0;
   for (Piece pc : Pieces)
-    for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1) {
-      if (!is_ok_R(s1)) continue;
-      for (Square s2 = Square(s1 + 1); s2 <= SQ_H8; ++s2) {
-        if (!is_ok_B(s2)) continue;
-        if (!is_ok_R(s2) && pc == RED) continue;
+    for (Square s1 = SQ_A1; s1 <= SQ_F6; ++s1) {
+      for (Square s2 = Square(s1 + 1); s2 <= SQ_F7; ++s2) {
         //if ((type_of(pc) != PAWN) && (attacks_bb(type_of(pc), s1, 0) & s2))
         if ((attacks_bb(type_of(pc), s1, 0) & s2))
         {
@@ -205,7 +215,6 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si, Th
 
   unsigned char col, row, token;
   size_t idx;
-  Square sq = SQUARE_ZERO;
   std::istringstream ss(fenStr);
 
   std::memset(this, 0, sizeof(Position));
@@ -217,28 +226,28 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si, Th
 
   // 1. Piece placement
   //S[4
-  put_piece(W_GOAL, SQ_B8);
-  put_piece(W_GOAL, SQ_G8);
-  put_piece(B_GOAL, SQ_B1);
-  put_piece(B_GOAL, SQ_G1);
+  put_piece(W_GOAL, SQ_A7);
+  put_piece(W_GOAL, SQ_F7);
+  put_piece(B_GOAL, SQ_A0);
+  put_piece(B_GOAL, SQ_F0);
 
   for (int i = 0; i < 4; ++i) 
     ss >> token;  //MOV?
-  int in_cnt = 0;
+  int in_cnt = 0, x = 0, y = 0;
   while (ss >> token && !isspace(token)) {
     if (isdigit(token)) {
       if (in_cnt == 0) {
-        sq += (token - '0' + 1) * EAST;
+        x = token - '0';
       }
       else {
-        sq += (token - '0' + 1) * NORTH;
+        y = token - '0';
       }
       ++in_cnt;
     }
     else if ((idx = PieceToChar.find(token)) != string::npos) {
-      if(is_ok_B(sq))
-        put_piece(Piece(idx), sq);
-      sq = SQUARE_ZERO;
+      //ꂽ (9, 9) őĂ
+      if (x < FILE_NB && y < RANK_NB)
+        put_piece(Piece(idx), make_square(File(x), Rank(y)));
       in_cnt = 0;
     }
   }
@@ -257,10 +266,11 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si, Th
       }
   }*/
 
-  // 2. Active color
-  //if(ss >> token)
-  //  sideToMove = (token == 'w' ? WHITE : BLACK);
-  //ss >> token;
+  // 2. Active color. The server never sends it (we are always to move), but
+  // fen() appends " b" so that positions with the opponent to move, e.g. the
+  // root of a ponder search, survive the copy to the search threads.
+  if ((ss >> std::skipws >> token) && token == 'b')
+    sideToMove = BLACK;
 
   // 3. Castling availability. Compatible with 3 standards: Normal FEN standard,
   // Shredder-FEN that uses the letters of the columns on which the rooks began
@@ -327,6 +337,13 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si, Th
   thisThread = th;
   set_state(st);
 
+  // Every piece starts on its own root square. Until set_red_probs() is
+  // called the unknown ghosts are even and never run out of either colour.
+  for (int s = 0; s < SQUARE_NB; ++s)
+      origin[s] = int8_t(s), redProb[s] = 0.5f;
+
+  rootReds = rootBlues = 16;
+
   assert(pos_is_ok());
 
   return *this;
@@ -356,34 +373,6 @@ void Position::set_castling_right(Color c, Square rfrom) {
 */
 
 
-/// Position::set_check_info() sets king attacks to detect if a move gives check
-
-void Position::set_check_info(StateInfo* si) const {
-
-  //si->blockersForKing[WHITE] = slider_blockers(pieces(BLACK), square<KING>(WHITE), si->pinners[BLACK]);
-  //si->blockersForKing[BLACK] = slider_blockers(pieces(WHITE), square<KING>(BLACK), si->pinners[WHITE]);
-  si->blockersForKing[WHITE] = 0;
-  si->blockersForKing[BLACK] = 0;
-
-  //Square ksq = square<KING>(~sideToMove);
-  //si->checkSquares[PAWN]   = pawn_attacks_bb(~sideToMove, ksq);
-  //si->checkSquares[KNIGHT] = attacks_bb<KNIGHT>(ksq);
-  //si->checkSquares[BISHOP] = attacks_bb<BISHOP>(ksq, pieces());
-  //si->checkSquares[ROOK]   = attacks_bb<ROOK>(ksq, pieces());
-  //si->checkSquares[QUEEN]  = si->checkSquares[BISHOP] | si->checkSquares[ROOK];
-  const Square* ksqs = squares<GOAL>(~sideToMove);
-  si->checkSquares[BLUE] = 0;
-  si->checkSquares[RED] = 0;
-  si->checkSquares[PURPLE] = 0;
-  si->checkSquares[GOAL] = 0;
-  for (Square ksq = *ksqs; ksq != SQ_NONE; ksq = *++ksqs) {
-    si->checkSquares[BLUE] |= attacks_bb<BLUE>(ksq);
-    //si->checkSquares[RED] |= attacks_bb<RED>(ksq);
-    si->checkSquares[PURPLE] |= attacks_bb<PURPLE>(ksq);
-  }
-}
-
-
 /// Position::set_state() computes the hash keys of the position, and other
 /// data that once computed is updated incrementally as moves are made.
 /// The function is only used when a new position is set up, and to verify
@@ -391,9 +380,10 @@ void Position::set_check_info(StateInfo* si) const {
 
 void Position::set_state(StateInfo* si) const {
 
-  si->key = si->materialKey = 0;
+  si->key = 0;
+  //si->materialKey = 0;
   //si->pawnKey = Zobrist::noPawns;
-  si->nonPawnMaterial[WHITE] = si->nonPawnMaterial[BLACK] = VALUE_ZERO;
+  //si->nonPawnMaterial[WHITE] = si->nonPawnMaterial[BLACK] = VALUE_ZERO;
   //si->checkersBB = attackers_to(square<KING>(sideToMove)) & pieces(~sideToMove);
   const Square* ksqs = squares<GOAL>(sideToMove);
   si->checkersBB = 0;
@@ -402,8 +392,6 @@ void Position::set_state(StateInfo* si) const {
   }
   si->checkersBB &= pieces(~sideToMove);
 
-  set_check_info(si);
-
   for (Bitboard b = pieces(); b; )
   {
       Square s = pop_lsb(&b);
@@ -425,9 +413,9 @@ void Position::set_state(StateInfo* si) const {
 
   //si->key ^= Zobrist::castling[si->castlingRights];
 
-  for (Piece pc : Pieces)
-      for (int cnt = 0; cnt < pieceCount[pc]; ++cnt)
-          si->materialKey ^= Zobrist::psq[pc][cnt];
+  //for (Piece pc : Pieces)
+  //    for (int cnt = 0; cnt < pieceCount[pc]; ++cnt)
+  //        si->materialKey ^= Zobrist::psq[pc][cnt];
 }
 
 
@@ -480,13 +468,12 @@ const string Position::fen() const {
   //        ss << '/';
   //}
   ss << 'M' << 'O' << 'V' << '?';
-  for (Rank r = RANK_8; r >= RANK_1; --r) {
-    for (File f = FILE_A; f <= FILE_H; ++f) {
+  for (Rank r = RANK_6; r >= RANK_1; --r) {
+    for (File f = FILE_A; f <= FILE_F; ++f) {
       Square sq = make_square(f, r);
-      if (!is_ok_B(sq)) continue;
       Piece pc = piece_on(sq);
-      if (pc == NO_PIECE || pc == GOAL) continue;
-      ss << f-1 << r-1;
+      if (pc == NO_PIECE || type_of(pc) == GOAL) continue;
+      ss << f << r;
       if (pc == W_RED)
         ss << 'R';
       else if (pc == W_BLUE)
@@ -495,9 +482,14 @@ const string Position::fen() const {
         ss << 'u';
       else if (pc == B_RED)
         ss << 'r';
+      else if (pc == B_BLUE)
+        ss << 'b';
     }
   }
 
+  if (sideToMove == BLACK)
+    ss << " b";
+
   //ss << (sideToMove == WHITE ? " w " : " b ");
 
   //if (can_castle(WHITE_OO))
@@ -668,8 +660,8 @@ bool Position::legal(Move m) const {
   // is moving along the ray towards or away from the king.
   //return   !(blockers_for_king(us) & from)
   //      ||  aligned(from, to, square<KING>(us));
-  return   !(blockers_for_king(us) & from)
-        ||  aligned(from, to, square<GOAL>(us));
+  //return   !(blockers_for_king(us) & from)
+  //      ||  aligned(from, to, square<GOAL>(us));
   return true;
 }
 
@@ -835,9 +827,11 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
   ++st->pliesFromNull;
 
   // Used by NNUE
-  st->accumulator.computed_accumulation = false;
-  auto& dp = st->dirtyPiece;
-  dp.dirty_num = 1;
+  if (acc)
+  {
+      (++acc)->computed_accumulation = false;
+      acc->dirtyPiece.dirty_num = 1;
+  }
 
   Color us = sideToMove;
   Color them = ~us;
@@ -889,19 +883,19 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
       //    st->pawnKey ^= Zobrist::psq[captured][capsq];
       //}
       //else
-          st->nonPawnMaterial[them] -= PieceValue[MG][captured];
+      //    st->nonPawnMaterial[them] -= PieceValue[MG][captured];
       
-      /*
-      if (Eval::useNNUE)
+      if (acc)
       {
+          auto& dp = acc->dirtyPiece;
           dp.dirty_num = 2;  // 1 piece moved, 1 piece captured
           dp.piece[1] = captured;
           dp.from[1] = capsq;
           dp.to[1] = SQ_NONE;
       }
-      */
 
       // Update board and piece lists
+      st->capturedOrigin = origin[capsq];
       remove_piece(capsq);
 
       //if (type_of(m) == ENPASSANT)
@@ -909,7 +903,7 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 
       // Update material hash key and prefetch access to materialTable
       k ^= Zobrist::psq[captured][capsq];
-      st->materialKey ^= Zobrist::psq[captured][pieceCount[captured]];
+      //st->materialKey ^= Zobrist::psq[captured][pieceCount[captured]];
       //prefetch(thisThread->materialTable[st->materialKey]);
 
       // Reset rule 50 counter
@@ -937,12 +931,13 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
   // Move the piece. The tricky Chess960 castling is handled earlier
   //if (type_of(m) != CASTLING)
   //{
-  //    if (Eval::useNNUE)
-  //    {
-  //        dp.piece[0] = pc;
-  //        dp.from[0] = from;
-  //        dp.to[0] = to;
-  //    }
+      if (acc)
+      {
+          auto& dp = acc->dirtyPiece;
+          dp.piece[0] = pc;
+          dp.from[0] = from;
+          dp.to[0] = to;
+      }
 
       move_piece(from, to);
   //}
@@ -1016,9 +1011,6 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 
   sideToMove = ~sideToMove;
 
-  // Update king attacks used for fast check detection
-  set_check_info(st);
-
   // Calculate the repetition info. It is the ply distance from the previous
   // occurrence of the same position, negative in the 3-fold case, or zero
   // if the position was not repeated.
@@ -1097,6 +1089,7 @@ void Position::undo_move(Move m) {
           //}
 
           put_piece(st->capturedPiece, capsq); // Restore the captured piece
+          origin[capsq] = st->capturedOrigin;
       }
   //}
 
@@ -1104,6 +1097,9 @@ void Position::undo_move(Move m) {
   st = st->previous;
   --gamePly;
 
+  if (acc)
+      --acc;
+
   //assert(pos_is_ok());
 }
 
@@ -1155,7 +1151,7 @@ void Position::do_null_move(StateInfo& newSt) {
       std::memcpy(&newSt, st, sizeof(StateInfo));
   }
   else */
-      std::memcpy(&newSt, st, offsetof(StateInfo, accumulator));
+      std::memcpy(&newSt, st, sizeof(StateInfo));
 
   newSt.previous = st;
   st = &newSt;
@@ -1174,8 +1170,6 @@ void Position::do_null_move(StateInfo& newSt) {
 
   sideToMove = ~sideToMove;
 
-  set_check_info(st);
-
   st->repetition = 0;
 
   //assert(pos_is_ok());
@@ -1190,6 +1184,74 @@ void Position::undo_null_move() {
 }
 
 
+/// Position::attach() gives the position the accumulator stack 'stack' for
+/// the incremental NNUE evaluation: do_move() records in the next entry what
+/// the move changed on the board, and undo_move() goes back to the previous
+/// one. The position is the root of the stack, so it must be attached again
+/// when the board is changed in another way.
+
+void Position::attach(Eval::NNUE::Accumulator* stack) {
+
+  acc = stack + 2;
+  stack[0].computed_accumulation = stack[1].computed_accumulation = false;
+  acc->computed_accumulation = false;
+}
+
+
+/// Position::set_red_probs() gives the probabilities that the opponent's
+/// ghosts on each square are red, and how many reds and blues there are among
+/// the unknown ones. It is called on the root position of a search.
+
+void Position::set_red_probs(const float* prob, int reds, int blues) {
+
+  std::copy(prob, prob + SQUARE_NB, redProb);
+  rootReds = reds;
+  rootBlues = blues;
+}
+
+
+/// Position::resolve_capture() decides the colour of the unknown ghost captured
+/// by the last move. The number of reds and blues found is part of the hash
+/// key, so the outcomes of a chance node do not share TT entries.
+/// undo_resolve_capture() must be called before the move is undone.
+
+void Position::resolve_capture(bool red) {
+
+  assert(capture_unresolved());
+
+  int8_t& n = red ? st->capturedRed : st->capturedBlue;
+  st->key ^= Zobrist::chance[red][n++];
+  st->capturedPiece = red ? B_RED : B_BLUE;
+}
+
+void Position::undo_resolve_capture() {
+
+  bool red = st->capturedPiece == B_RED;
+  int8_t& n = red ? st->capturedRed : st->capturedBlue;
+
+  assert(st->capturedPiece == B_RED || st->capturedPiece == B_BLUE);
+
+  st->key ^= Zobrist::chance[red][--n];
+  st->capturedPiece = B_PURPLE;
+}
+
+
+/// Position::material_key() computes the material hash key from the piece
+/// counts. It is only needed outside of the search (endgame and tablebase
+/// lookups), so it is not kept incrementally in StateInfo.
+
+Key Position::material_key() const {
+
+  Key k = 0;
+
+  for (Piece pc : Pieces)
+      for (int cnt = 0; cnt < pieceCount[pc]; ++cnt)
+          k ^= Zobrist::psq[pc][cnt];
+
+  return k;
+}
+
+
 /// Position::key_after() computes the new hash key after the given move. Needed
 /// for speculative prefetch. It doesn't recognize special moves like castling,
 /// en-passant and promotions.
@@ -1248,8 +1310,8 @@ bool Position::see_ge(Move m, Value threshold) const {
 
       // Don't allow pinned pieces to attack (except the king) as long as
       // there are pinners on their original square.
-      if (pinners(~stm) & occupied)
-          stmAttackers &= ~blockers_for_king(stm);
+      //if (pinners(~stm) & occupied)
+      //    stmAttackers &= ~blockers_for_king(stm);
 
       if (!stmAttackers)
           break;
@@ -1423,7 +1485,7 @@ void Position::flip() {
   string f, token;
   std::stringstream ss(fen());
 
-  for (Rank r = RANK_8; r >= RANK_1; --r) // Piece placement
+  for (Rank r = RANK_6; r >= RANK_1; --r) // Piece placement
   {
       std::getline(ss, token, r > RANK_1 ? '/' : ' ');
       f.insert(0, token + (f.empty() ? " " : "/"));
@@ -1469,9 +1531,10 @@ bool Position::pos_is_ok() const {
         && relative_rank(sideToMove, ep_square()) != RANK_6)*/)
   {
     char cr[8] = {' ','B','R','P','G','?','?','?'};
-    for (Rank r = RANK_1; r <= RANK_8; ++r) {
-      for (File f = FILE_A; f <= FILE_H; ++f) {
-        std::cout << cr[type_of(piece_on(make_square(f, r)))];
+    for (Rank r = RANK_0; r <= RANK_7; ++r) {
+      for (File f = FILE_A; f <= FILE_F; ++f) {
+        Square sq = make_square(f, r);
+        std::cout << (is_ok(sq) ? cr[type_of(piece_on(sq))] : ' ');
       }
       std::cout << std::endl;
     }
@@ -28,39 +28,45 @@
 #include "evaluate.h"
 #include "types.h"
 
-#include "nnue/nnue_accumulator.h"
+namespace Eval::NNUE { struct Accumulator; }
 
 
 /// StateInfo struct stores information needed to restore a Position object to
 /// its previous state when we retract a move. Whenever a move is made on the
 /// board (by calling Position::do_move), a StateInfo object must be passed.
 
+//KCX^[Ŏĝc (`FX̋̉lEsENNUE ͎̍Ȃ)
 struct StateInfo {
 
   // Copied when making a move
   //Key    pawnKey;
-  Key    materialKey;
-  Value  nonPawnMaterial[COLOR_NB];
+  //Key    materialKey;
+  //Value  nonPawnMaterial[COLOR_NB];
   //int    castlingRights;
-  int    rule50;
-  int    pliesFromNull;
+  int16_t rule50;
+  int16_t pliesFromNull;
+  int8_t  capturedRed, capturedBlue; // Unknown ghosts found red/blue by the chance nodes
   //Square epSquare;
 
   // Not copied when making a move (will be recomputed anyhow)
   Key        key;
   Bitboard   checkersBB;  //"" -> Eo
   Piece      capturedPiece;
+  int16_t    repetition;
+  int8_t     capturedOrigin; // Root square of the captured piece
   StateInfo* previous;
-  Bitboard   blockersForKing[COLOR_NB];
-  Bitboard   pinners[COLOR_NB];
-  Bitboard   checkSquares[PIECE_TYPE_NB];
-  int        repetition;
+  //Bitboard   blockersForKing[COLOR_NB];
+  //Bitboard   pinners[COLOR_NB];
+  //Bitboard   checkSquares[PIECE_TYPE_NB];
 
   // Used by NNUE
-  Eval::NNUE::Accumulator accumulator;
-  DirtyPiece dirtyPiece;
+  //Eval::NNUE::Accumulator accumulator;
+  //DirtyPiece dirtyPiece;
 };
 
+//do_move() ̂тɃRs[ATX^bN StateListPtr ɑʂɕԂ̂ŏۂ
+static_assert(sizeof(StateInfo) <= 40, "StateInfo should stay within 40 bytes");
+
 
 /// A list to keep track of the position states along the setup moves (from the
 /// start position to the position just before the search starts). Needed by
@@ -116,10 +122,10 @@ public:
 
   // Checking
   Bitboard checkers() const;
-  Bitboard blockers_for_king(Color c) const;
+  //Bitboard blockers_for_king(Color c) const;
   Bitboard check_squares(PieceType pt) const;
-  Bitboard pinners(Color c) const;
-  bool is_discovery_check_on_king(Color c, Move m) const;
+  //Bitboard pinners(Color c) const;
+  //bool is_discovery_check_on_king(Color c, Move m) const;
 
   // Attacks to/from a given square
   Bitboard attackers_to(Square s) const;
@@ -176,14 +182,26 @@ public:
 
   // Used by NNUE
   StateInfo* state() const;
+  Eval::NNUE::Accumulator* accumulator() const;
+  void attach(Eval::NNUE::Accumulator* stack);
 
   void piece_change(Piece pc, Square s);
 
+  // Chance nodes for the captures of the opponent's unknown ghosts
+  void set_red_probs(const float* prob, int reds, int blues);
+  bool capture_unresolved() const;
+  float captured_red_prob() const;
+  int reds_left() const;
+  int blues_left() const;
+  int reds_found() const;
+  void resolve_capture(bool red);
+  void undo_resolve_capture();
+
 private:
   // Initialization helpers (used while setting up a position)
   //void set_castling_right(Color c, Square rfrom);
   void set_state(StateInfo* si) const;
-  void set_check_info(StateInfo* si) const;
+  //void set_check_info(StateInfo* si) const;
 
   // Other helpers
   void put_piece(Piece pc, Square s);
@@ -199,6 +217,9 @@ private:
   int pieceCount[PIECE_NB];
   Square pieceList[PIECE_NB][16];
   int index[SQUARE_NB];
+  int8_t origin[SQUARE_NB];  // Square of the piece at the root, follows it like index[]
+  float redProb[SQUARE_NB];  // Probability that the ghost from root square s is red
+  int rootReds, rootBlues;   // Reds and blues among the unknown ghosts at the root
   //int castlingRightsMask[SQUARE_NB];
   //Square castlingRookSquare[CASTLING_RIGHT_NB];
   //Bitboard castlingPath[CASTLING_RIGHT_NB];
@@ -207,6 +228,7 @@ private:
   Score psq;
   Thread* thisThread;
   StateInfo* st;
+  Eval::NNUE::Accumulator* acc; // Top of the accumulator stack, if any
   bool chess960;
 };
 
@@ -323,6 +345,8 @@ inline Bitboard Position::checkers() const {
   return st->checkersBB;
 }
 
+//KCX^[̋1}XȂ̂ŁAsJ͂Ȃ
+/*
 inline Bitboard Position::blockers_for_king(Color c) const {
   return st->blockersForKing[c];
 }
@@ -330,14 +354,22 @@ inline Bitboard Position::blockers_for_king(Color c) const {
 inline Bitboard Position::pinners(Color c) const {
   return st->pinners[c];
 }
+*/
 
+//̃S[ɗt}X. S[͓Ȃ̂ StateInfo Ɏɂ̓sx߂
 inline Bitboard Position::check_squares(PieceType pt) const {
-  return st->checkSquares[pt];
+  Bitboard b = 0;
+  const Square* ksqs = squares<GOAL>(~sideToMove);
+  for (Square ksq = *ksqs; ksq != SQ_NONE; ksq = *++ksqs)
+      b |= attacks_bb(pt, ksq, 0);
+  return b;
 }
 
+/*
 inline bool Position::is_discovery_check_on_king(Color c, Move m) const {
   return st->blockersForKing[c] & from_sq(m);
 }
+*/
 
 /*
 inline bool Position::pawn_passed(Color c, Square s) const {
@@ -368,16 +400,13 @@ inline Key Position::pawn_key() const {
 }
 */
 
-inline Key Position::material_key() const {
-  return st->materialKey;
-}
-
 inline Score Position::psq_score() const {
   return psq;
 }
 
-inline Value Position::non_pawn_material(Color c) const {
-  return st->nonPawnMaterial[c];
+//KCX^[̋ɂ͉lȂ̂ŏ0 (Null move ̎}͓Ȃ)
+inline Value Position::non_pawn_material(Color) const {
+  return VALUE_ZERO;
 }
 
 inline Value Position::non_pawn_material() const {
@@ -425,13 +454,36 @@ inline Piece Position::captured_piece() const {
   return st->capturedPiece;
 }
 
+/// An unknown ghost captured by the last move stays B_PURPLE until the search
+/// has chosen its colour with resolve_capture().
+
+inline bool Position::capture_unresolved() const {
+  return st->capturedPiece == B_PURPLE;
+}
+
+inline float Position::captured_red_prob() const {
+  return redProb[st->capturedOrigin];
+}
+
+inline int Position::reds_left() const {
+  return rootReds - st->capturedRed;
+}
+
+inline int Position::blues_left() const {
+  return rootBlues - st->capturedBlue;
+}
+
+inline int Position::reds_found() const {
+  return st->capturedRed;
+}
+
 inline Thread* Position::this_thread() const {
   return thisThread;
 }
 
 inline void Position::put_piece(Piece pc, Square s) {
   assert(pc != NO_PIECE);
-  if (!(s >= SQ_A1 && s <= SQ_H8)) {
+  if (!is_ok(s)) {
     return;
   }
   board[s] = pc;
@@ -478,6 +530,7 @@ inline void Position::move_piece(Square from, Square to) {
   board[from] = NO_PIECE;
   board[to] = pc;
   index[to] = index[from];
+  origin[to] = origin[from];
   pieceList[pc][index[to]] = to;
   //psq += PSQT::psq[pc][to] - PSQT::psq[pc][from];
 }
@@ -491,6 +544,11 @@ inline StateInfo* Position::state() const {
   return st;
 }
 
+inline Eval::NNUE::Accumulator* Position::accumulator() const {
+
+  return acc;
+}
+
 inline void Position::piece_change(Piece pc, Square s) {
   assert(s != SQ_NONE);
   assert(pc != NO_PIECE);
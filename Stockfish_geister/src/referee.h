@@ -0,0 +1,185 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REFEREE_H_INCLUDED
+#define REFEREE_H_INCLUDED
+
+#include <string>
+
+/// The Referee namespace keeps the true board of a Geister game, both sides'
+/// colours included, and speaks the board and move strings of the game
+/// server's protocol. It is used by geister_server and by the engine's own
+/// self-play, and does not depend on the rest of the engine.
+
+namespace Referee {
+
+enum Outcome { NONE, WIN, LOSS, DRAW }; // Seen from the player to move
+
+constexpr int BoardSize = 6;
+constexpr int Captured  = 9;   // Coordinates of captured ghosts ("99")
+constexpr int Escaped   = 8;   // Coordinates of escaped ghosts ("88")
+constexpr int MaxPlies  = 300; // The game is drawn after this many plies
+
+/// Ghost is one piece. Coordinates are kept from the first player's point
+/// of view; the second player sees the board rotated by 180 degrees.
+
+struct Ghost {
+  int x, y;
+  bool red;
+};
+
+class Game {
+
+  Ghost ghosts[2][8] = {};
+  int plies = 0;
+
+  static bool on_board(int x, int y) {
+    return x >= 0 && x < BoardSize && y >= 0 && y < BoardSize;
+  }
+
+  // view() converts absolute coordinates to those of player 'p' and back
+  static int view(int p, int c) { return p == 0 || c >= BoardSize ? c : BoardSize - 1 - c; }
+
+  int count(int p, bool red) const {
+    int n = 0;
+    for (const Ghost& g : ghosts[p])
+        n += g.red == red && on_board(g.x, g.y);
+    return n;
+  }
+
+  bool escaped(int p) const {
+    for (const Ghost& g : ghosts[p])
+        if (g.x == Escaped)
+            return true;
+    return false;
+  }
+
+public:
+  int ply() const { return plies; }
+
+  // set() places the ghosts of player 'p' on their starting squares with
+  // the red ones named in 'reds'. It returns false on a malformed choice.
+  bool set(int p, const std::string& reds) {
+
+    if (reds.size() != 4)
+        return false;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        int x = 1 + i % 4, y = 4 + i / 4; // A-D on row 4, E-H on row 5
+        ghosts[p][i] = { view(p, x), view(p, y), false };
+    }
+
+    for (char c : reds)
+    {
+        if (c < 'A' || c > 'H' || ghosts[p][c - 'A'].red)
+            return false;
+        ghosts[p][c - 'A'].red = true;
+    }
+
+    plies = 0;
+    return true;
+  }
+
+  // board() is the board string sent to player 'p'. With 'reveal' set the
+  // colours of the opponent's ghosts are shown, as at the end of a game.
+  std::string board(int p, bool reveal) const {
+
+    std::string s;
+
+    for (int side : { p, 1 - p })
+        for (const Ghost& g : ghosts[side])
+        {
+            s += char('0' + view(p, g.x));
+            s += char('0' + view(p, g.y));
+
+            if (on_board(g.x, g.y))
+                s += side != p ? (reveal ? (g.red ? 'r' : 'b') : 'u') : (g.red ? 'R' : 'B');
+            else
+                s += g.red ? 'r' : 'b';
+        }
+
+    return s;
+  }
+
+  // do_move() plays the move "A,N" of player 'p'. It returns false if the
+  // move is illegal and otherwise the outcome for 'p' after the move.
+  bool do_move(int p, const std::string& mv, Outcome& outcome, std::string& reason) {
+
+    if (mv.size() != 3 || mv[0] < 'A' || mv[0] > 'H' || mv[1] != ',')
+        return false;
+
+    Ghost& g = ghosts[p][mv[0] - 'A'];
+    int dx = 0, dy = 0; // In the coordinates of player 'p'
+
+    switch (mv[2]) {
+    case 'N': dy = -1; break;
+    case 'S': dy =  1; break;
+    case 'E': dx =  1; break;
+    case 'W': dx = -1; break;
+    default: return false;
+    }
+
+    if (!on_board(g.x, g.y))
+        return false;
+
+    int vx = view(p, g.x) + dx, vy = view(p, g.y) + dy;
+
+    if (!on_board(vx, vy))
+    {
+        // A blue ghost on one of the opponent's corners may leave the board
+        if (g.red || view(p, g.y) != 0 || (view(p, g.x) != 0 && view(p, g.x) != BoardSize - 1))
+            return false;
+
+        g.x = g.y = Escaped;
+    }
+    else
+    {
+        int x = view(p, vx), y = view(p, vy);
+
+        for (const Ghost& o : ghosts[p])
+            if (o.x == x && o.y == y)
+                return false;
+
+        for (Ghost& o : ghosts[1 - p])
+            if (o.x == x && o.y == y)
+                o.x = o.y = Captured;
+
+        g.x = x, g.y = y;
+    }
+
+    ++plies;
+
+    outcome = NONE;
+
+    if (escaped(p))
+        outcome = WIN, reason = "escaped";
+
+    else if (count(1 - p, false) == 0)
+        outcome = WIN, reason = "took all blue";
+
+    else if (count(1 - p, true) == 0)
+        outcome = LOSS, reason = "took all red";
+
+    return true;
+  }
+};
+
+} // namespace Referee
+
+#endif // #ifndef REFEREE_H_INCLUDED
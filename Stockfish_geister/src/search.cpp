@@ -23,7 +23,11 @@
 #include <iostream>
 #include <sstream>
 
+#include "belief.h"
+#include "book.h"
+#include "escape.h"
 #include "evaluate.h"
+#include "mcts.h"
 #include "misc.h"
 #include "movegen.h"
 #include "movepick.h"
@@ -34,6 +38,8 @@
 #include "tt.h"
 #include "uci.h"
 #include "syzygy/tbprobe.h"
+#include "telemetry.h"
+#include "tcp.h"
 #include "Game_geister.h"
 
 namespace Search {
@@ -45,7 +51,6 @@ namespace Tablebases {
 
   int Cardinality;
   bool RootInTB;
-  bool UseRule50;
   Depth ProbeDepth;
 }
 
@@ -151,6 +156,9 @@ namespace {
   template <NodeType NT>
   Value qsearch(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth = 0);
 
+  template <NodeType NT>
+  Value chance(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth, bool cutNode);
+
   Value value_to_tt(Value v, int ply);
   Value value_from_tt(Value v, int ply, int r50c);
   void update_pv(Move* pv, Move move, Move* childPv);
@@ -158,9 +166,12 @@ namespace {
   void update_quiet_stats(const Position& pos, Stack* ss, Move move, int bonus, int depth);
   void update_all_stats(const Position& pos, Stack* ss, Move bestMove, Value bestValue, Value beta, Square prevSq,
     Move* quietsSearched, int quietCount, Move* capturesSearched, int captureCount, Depth depth);
+  void write_telemetry(const Position& pos, const Thread* th, const char* backend);
 
   // perft() is our utility to verify move generation. All the leaf nodes up
   // to the given depth are generated and counted, and the sum is returned.
+  // The last ply is bulk counted from the size of the move list, and at the
+  // root the count of every move is printed (divide).
   template<bool Root>
   uint64_t perft(Position& pos, Depth depth) {
 
@@ -218,16 +229,36 @@ void MainThread::search() {
   if (Limits.perft)
   {
     nodes = perft<true>(rootPos, Limits.perft);
-    sync_cout << "\nNodes searched: " << nodes << "\n" << sync_endl;
+    TimePoint elapsed = now() - Limits.startTime + 1; // Avoid a 'divide by zero'
+    sync_cout << "\nNodes searched: " << nodes
+              << "\nNodes/second: " << 1000 * nodes / elapsed << "\n" << sync_endl;
     return;
   }
 
   Color us = rootPos.side_to_move();
-  Time.init(Limits, us, rootPos.game_ply());
+  Time.init(Limits, rootPos);
+
+  // The PIMC rounds and the ISMCTS have no iterations to stop after, so on a
+  // clock they are given a fixed movetime
+  if (Limits.use_time_management() && (Limits.mcts || !Limits.samples.empty()))
+      Limits.movetime = Time.optimum();
   TT.new_search();
 
   //Eval::NNUE::verify();
 
+  // A book move is played at once, without waking up the other threads
+  const Book::Entry* book = Limits.infinite || ponder ? nullptr : Book::probe(rootPos);
+  auto bookMove = book ? std::find(rootMoves.begin(), rootMoves.end(), Move(book->move)) : rootMoves.end();
+  bool inBook = bookMove != rootMoves.end();
+
+  // So is the move of a solved escape race
+  Move escapeMove = MOVE_NONE;
+  Value escapeValue = inBook || Limits.infinite || ponder || rootMoves.empty() ? VALUE_NONE
+                    : Escape::solve(rootPos, escapeMove);
+  auto solvedMove = escapeValue != VALUE_NONE ? std::find(rootMoves.begin(), rootMoves.end(), escapeMove)
+                                              : rootMoves.end();
+  bool solved = solvedMove != rootMoves.end();
+
   if (rootMoves.empty())
   {
     rootMoves.emplace_back(MOVE_NONE);
@@ -235,6 +266,27 @@ void MainThread::search() {
       << UCI::value(rootPos.checkers() ? -VALUE_MATE : VALUE_DRAW)
       << sync_endl;
   }
+  else if (inBook)
+  {
+    std::swap(rootMoves[0], *bookMove);
+    sync_cout << "info string book " << UCI::move(rootMoves[0].pv[0], rootPos.is_chess960())
+              << " score " << int(100 * book->stats.score() + 0.5) << "% of "
+              << book->stats.games() << " games" << sync_endl;
+  }
+  else if (solved)
+  {
+    std::swap(rootMoves[0], *solvedMove);
+    rootMoves[0].score = escapeValue;
+    sync_cout << "info depth " << VALUE_MATE - std::abs(escapeValue)
+              << " score " << UCI::value(escapeValue)
+              << " nodes " << Threads.nodes_searched()
+              << " time " << Time.elapsed()
+              << " pv " << UCI::move(escapeMove, rootPos.is_chess960()) << sync_endl;
+  }
+  else if (Limits.mcts)
+    search_mcts();
+  else if (!Limits.samples.empty())
+    search_samples();
   else
   {
     Threads.start_searching(); // start non-main threads
@@ -247,9 +299,7 @@ void MainThread::search() {
   // GUI sends a "stop" or "ponderhit" command. We therefore simply wait here
   // until the GUI sends one of those commands.
 
-  while (!Threads.stop && (ponder || Limits.infinite))
-  {
-  } // Busy wait for a stop or a ponder reset
+  wait_for_stop();
 
  // Stop the threads if not already stopped (also raise the stop if
  // "ponderhit" just reset Threads.ponder).
@@ -258,6 +308,12 @@ void MainThread::search() {
   // Wait until all threads have finished
   Threads.wait_for_search_finished();
 
+  // A ponder search is stopped when the opponent's move arrives. It searched
+  // from the opponent's point of view only to fill the TT for our next search,
+  // so there is no move to send and the previous results are kept.
+  if (ponder)
+    return;
+
   // When playing in 'nodes as time' mode, subtract the searched nodes from
   // the available ones before exiting.
   if (Limits.npmsec)
@@ -266,7 +322,11 @@ void MainThread::search() {
   Thread* bestThread = this;
 
   if (int(Options["MultiPV"]) == 1
+    && Limits.samples.empty()
+    && !Limits.mcts
     && !Limits.depth
+    && !inBook
+    && !solved
     && !(Skill(Options["Skill Level"]).enabled() || int(Options["UCI_LimitStrength"]))
     && rootMoves[0].pv[0] != MOVE_NONE)
     bestThread = Threads.get_best_thread();
@@ -285,18 +345,154 @@ void MainThread::search() {
   //std::cout << sync_endl;
 
   std::cout << bestThread->rootMoves[0].score << std::endl;
-  Move mv = bestThread->rootMoves[0].pv[0];
+  Move mv = bestMove = bestThread->rootMoves[0].pv[0];
+
+  if (Telemetry::enabled())
+      write_telemetry(rootPos, bestThread, inBook                  ? "book"
+                                         : solved                  ? "escape"
+                                         : Limits.mcts             ? "ismcts"
+                                         : !Limits.samples.empty() ? "pimc" : "alphabeta");
+
+  // Without a game server (e.g. bench or UCI commands given on the command
+  // line) just report the move as the UCI protocol does.
+  if (!tcp::is_open(tcp::dstSocket))
+  {
+    sync_cout << "bestmove " << UCI::move(mv, rootPos.is_chess960()) << sync_endl;
+    return;
+  }
+
   Red::myMove(mv);
   tcp::mySend(tcp::dstSocket, tcp::MoveStr(mv));			//s̑M
 }
 
 
+/// MainThread::search_samples() is the perfect information Monte Carlo (PIMC)
+/// search. Limits.samples holds complete red/blue assignments of the
+/// opponent's ghosts; each thread searches one of them as a normal position,
+/// in as many rounds as needed to cover all the samples with the threads we
+/// have, and the time is split evenly between the rounds. Every root move is
+/// scored exactly (MultiPV over all the moves) and the scores are averaged
+/// over the samples. The move with the best average goes to the front of
+/// rootMoves, where MainThread::search() picks the best move. The reds are
+/// known in the samples only, so Red::existRed is set for their searches and
+/// restored afterwards: later searches of the real board, e.g. a ponder
+/// search, must not take its missing reds for a win. The root position is
+/// restored too, as start_thinking() sets it, since the move, the ponder move
+/// and the telemetry are taken from it.
+
+void MainThread::search_samples() {
+
+  const size_t n = Threads.size(), k = Limits.samples.size();
+  const size_t rounds = (k + n - 1) / n;
+  const TimePoint movetime = Limits.movetime;
+  const bool existRed = Red::existRed;
+  const std::string fen = rootPos.fen();
+  const StateInfo st = rootState;
+  std::map<Move, std::pair<int64_t, int>> total; // Sum of scores and samples
+
+  Red::existRed = true;
+
+  for (size_t r = 0; r < rounds; ++r)
+  {
+      // Each round ends at its share of the movetime, counted from the start
+      if (movetime)
+          Limits.movetime = std::max(TimePoint(1), movetime * TimePoint(r + 1) / TimePoint(rounds));
+
+      Threads.set_samples(r * n);
+      Threads.start_searching(); // start non-main threads
+      Thread::search();          // main thread start searching
+
+      Threads.stop = true;
+      Threads.wait_for_search_finished();
+
+      for (size_t i = 0; i < std::min(n, k - r * n); ++i)
+          for (const RootMove& rm : Threads[i]->rootMoves)
+          {
+              Value v = rm.score != -VALUE_INFINITE ? rm.score : rm.previousScore;
+              if (v != -VALUE_INFINITE)
+              {
+                  total[rm.pv[0]].first += v;
+                  total[rm.pv[0]].second++;
+              }
+          }
+  }
+
+  Limits.movetime = movetime;
+  Red::existRed = existRed;
+
+  rootPos.set(fen, false, &rootState, this);
+  rootState = st;
+  if (Eval::useNNUE)
+      rootPos.attach(accumulators);
+  Belief::set_red_probs(rootPos);
+
+  // Restore our own root position and bring the best average to the front
+  for (RootMove& rm : rootMoves)
+      if (total.count(rm.pv[0]))
+      {
+          auto [sum, cnt] = total[rm.pv[0]];
+          rm.score = Value(sum / cnt);
+          rm.pv.resize(1);
+      }
+      else
+          rm.score = -VALUE_INFINITE;
+
+  std::stable_sort(rootMoves.begin(), rootMoves.end());
+
+  sync_cout << "info string pimc samples " << k << " rounds " << rounds
+            << " best " << UCI::move(rootMoves[0].pv[0], false)
+            << " score " << rootMoves[0].score << sync_endl;
+}
+
+
+/// MainThread::search_mcts() searches with the information set MCTS backend
+/// (see mcts.cpp) instead of alpha-beta. All the threads add iterations to
+/// the same tree until the search is stopped, then the root moves are sorted
+/// by visits and the iterations per second are reported, next to the nodes
+/// per second to compare with the alpha-beta search, and the tree size.
+
+void MainThread::search_mcts() {
+
+  MCTS::start(rootPos);
+
+  Threads.start_searching(); // start non-main threads
+  Thread::search();          // main thread start searching
+
+  Threads.stop = true;
+  Threads.wait_for_search_finished();
+
+  MCTS::update_root_moves(rootMoves);
+
+  TimePoint elapsed = Time.elapsed() + 1;
+  uint64_t iters = Threads.iterations_searched(), nodesSearched = Threads.nodes_searched();
+  size_t treeNodes = 0;
+
+  for (Thread* th : Threads)
+      treeNodes += th->nodePool.size();
+
+  sync_cout << "info string ismcts iterations " << iters
+            << " nodes " << nodesSearched
+            << " time " << elapsed
+            << " ips " << 1000 * iters / elapsed
+            << " nps " << 1000 * nodesSearched / elapsed
+            << " tree " << treeNodes
+            << " best " << UCI::move(rootMoves[0].pv[0], false)
+            << " score " << rootMoves[0].score << sync_endl;
+}
+
+
 /// Thread::search() is the main iterative deepening loop. It calls search()
 /// repeatedly with increasing depth until the allocated thinking time has been
 /// consumed, the user stops the search, or the maximum search depth is reached.
 
 void Thread::search() {
 
+  if (Limits.mcts)
+  {
+      MCTS::search(this);
+      return;
+  }
+
   // To allow access to (ss-7) up to (ss+2), the stack must be oversized.
   // The former is needed to allow update_continuation_histories(ss-1, ...),
   // which accesses its argument at ss-6, also near the root.
@@ -335,6 +531,10 @@ void Thread::search() {
 
   size_t multiPV = size_t(Options["MultiPV"]);
 
+  // A PIMC search needs an exact score for every root move of its sample
+  if (!Limits.samples.empty())
+    multiPV = rootMoves.size();
+
   // Pick integer skill levels, but non-deterministically round up or down
   // such that the average integer skill corresponds to the input floating point one.
   // UCI_Elo is converted to a suitable fractional skill level, using anchoring
@@ -528,7 +728,7 @@ void Thread::search() {
       }
       double bestMoveInstability = 1 + 2 * totBestMoveChanges / Threads.size();
 
-      double totalTime = rootMoves.size() == 1 ? 0 :
+      double totalTime = rootMoves.size() == 1 || rootMoves[0].pv[0] == Time.only_move() ? 0 :
         Time.optimum() * fallingEval * reduction * bestMoveInstability;
 
       // Stop the search if we have exceeded the totalTime, at least 1ms search
@@ -572,6 +772,10 @@ namespace {
   template <NodeType NT>
   Value search(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth, bool cutNode) {
 
+    // The last move captured a ghost of unknown colour
+    if (Limits.chance && !Red::existRed && ss->ply && pos.capture_unresolved())
+        return chance<NT>(pos, ss, alpha, beta, depth, cutNode);
+
     //evaluateɎƏĂ
     //肭Ȃ̂Ŗ肱
     if (Red::existRed) {
@@ -584,7 +788,14 @@ namespace {
     }
     else {
       if (pos.side_to_move() == BLACK) {
-        if (pos.count<PURPLE>(BLACK) <= Game_::bNum) {
+        //mm[hŎ̐F߂Ă, ͐mɂ킩
+        if (Limits.chance) {
+          if (pos.reds_left() <= 0)
+            return mate_in(ss->ply);
+          if (pos.blues_left() <= 0)
+            return mated_in(ss->ply);
+        }
+        else if (pos.count<PURPLE>(BLACK) <= Game_::bNum) {
           if (Game_::lost_pattern == 0) {
             return mate_in(ss->ply) / Game_::rNum - 500;
           }
@@ -780,11 +991,13 @@ namespace {
     // Step 5. Tablebases probe
     if (!rootNode && TB::Cardinality)
     {
-      int piecesCount = pos.count<ALL_PIECES>();
+      // Tables count the ghosts, not the goals. Geister has no 50-move rule,
+      // so the tables are exact after any move, not only after a capture.
+      int piecesCount = pos.count<ALL_PIECES>() - pos.count<GOAL>();
 
       if (piecesCount <= TB::Cardinality
         && (piecesCount < TB::Cardinality || depth >= TB::ProbeDepth)
-        && pos.rule50_count() == 0
+        /*&& pos.rule50_count() == 0*/
         /*&& !pos.can_castle(ANY_CASTLING)*/)
       {
         TB::ProbeState err;
@@ -798,15 +1011,13 @@ namespace {
         {
           thisThread->tbHits.fetch_add(1, std::memory_order_relaxed);
 
-          int drawScore = TB::UseRule50 ? 1 : 0;
-
           // use the range VALUE_MATE_IN_MAX_PLY to VALUE_TB_WIN_IN_MAX_PLY to score
-          value = wdl < -drawScore ? VALUE_MATED_IN_MAX_PLY + ss->ply + 1
-            : wdl >  drawScore ? VALUE_MATE_IN_MAX_PLY - ss->ply - 1
-            : VALUE_DRAW + 2 * wdl * drawScore;
+          value = wdl < TB::WDLDraw ? VALUE_MATED_IN_MAX_PLY + ss->ply + 1
+            : wdl > TB::WDLDraw ? VALUE_MATE_IN_MAX_PLY - ss->ply - 1
+            : VALUE_DRAW;
 
-          Bound b = wdl < -drawScore ? BOUND_UPPER
-            : wdl >  drawScore ? BOUND_LOWER : BOUND_EXACT;
+          Bound b = wdl < TB::WDLDraw ? BOUND_UPPER
+            : wdl > TB::WDLDraw ? BOUND_LOWER : BOUND_EXACT;
 
           if (b == BOUND_EXACT
             || (b == BOUND_LOWER ? value >= beta : value <= alpha))
@@ -1172,7 +1383,7 @@ namespace {
 
       // Check extension (~2 Elo)
       else if (givesCheck
-        && (pos.is_discovery_check_on_king(~us, move) || pos.see_ge(move)))
+        && pos.see_ge(move))
         extension = 1;
 
       // Last captures extension
@@ -1461,6 +1672,9 @@ namespace {
   template <NodeType NT>
   Value qsearch(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth) {
 
+    if (Limits.chance && !Red::existRed && ss->ply && pos.capture_unresolved())
+        return chance<NT>(pos, ss, alpha, beta, depth, false);
+
     //evaluateɎƏĂ
     //肭Ȃ̂Ŗ肱
     if (Red::existRed) {
@@ -1473,7 +1687,14 @@ namespace {
     }
     else {
       if (pos.side_to_move() == BLACK) {
-        if (pos.count<PURPLE>(BLACK) <= Game_::bNum) {
+        //mm[hŎ̐F߂Ă, ͐mɂ킩
+        if (Limits.chance) {
+          if (pos.reds_left() <= 0)
+            return mate_in(ss->ply);
+          if (pos.blues_left() <= 0)
+            return mated_in(ss->ply);
+        }
+        else if (pos.count<PURPLE>(BLACK) <= Game_::bNum) {
           if (Game_::lost_pattern == 0) {
             return mate_in(ss->ply) / Game_::rNum - 500;
           }
@@ -1666,7 +1887,6 @@ namespace {
 
       // Do not search moves with negative SEE values
       if (!ss->inCheck
-        && !(givesCheck && pos.is_discovery_check_on_king(~pos.side_to_move(), move))
         && !pos.see_ge(move))
         continue;
 
@@ -1736,6 +1956,154 @@ namespace {
   }
 
 
+  // chance() is the expectimax node after a capture of a ghost of unknown
+  // colour: the position is searched once for each colour of the captured
+  // ghost and the results are weighted by its red probability. Scores are
+  // mixed as winning chances (a logistic of the score, ExistWeight being
+  // about 84%), so that a small chance to win at once does not outweigh the
+  // rest of the position. Colours less likely than MinChance are ignored.
+  //
+  // At PV nodes the likelier colour is searched first with the Star1 window,
+  // outside of which the node fails low or high whatever the other colour
+  // gives, and the other one with the window that maps back to the window of
+  // the node. At non-PV nodes every search is a null window probe, which only
+  // bounds its colour from above or below: the colours are probed in turn,
+  // each at the score that decides the node given the last bound of the other,
+  // until the bounds of both decide it.
+
+  constexpr double ChanceScale = 600.0;
+  constexpr double MinChance = 0.01;
+
+  double win_chance(Value v) {
+    return 1.0 / (1.0 + std::exp(-int(v) / ChanceScale));
+  }
+
+  double chance_score(double w) {
+    return ChanceScale * std::log(w / (1 - w));
+  }
+
+  // chance_bound() is the lowest score with a winning chance of at least 'w'
+  Value chance_bound(double w) {
+    return w <= 0 ? -VALUE_INFINITE
+         : w >= 1 ?  VALUE_INFINITE
+         : Value(std::clamp(int(std::ceil(chance_score(w))), -int(VALUE_INFINITE) + 1, int(VALUE_INFINITE) - 1));
+  }
+
+  template <NodeType NT>
+  Value chance(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth, bool cutNode) {
+
+    constexpr bool PvNode = NT == PV;
+
+    auto outcome = [&](bool red, Value a, Value b) {
+        pos.resolve_capture(red);
+        Value v = depth > 0 ? search<NT>(pos, ss, a, b, depth, cutNode)
+                            : qsearch<NT>(pos, ss, a, b, depth);
+        pos.undo_resolve_capture();
+        return v;
+    };
+
+    // Mixed scores stay clear of the mate scores
+    auto to_value = [](double w) {
+        w = std::clamp(w, 1e-9, 1 - 1e-9);
+        return Value(std::clamp(int(std::lround(chance_score(w))),
+                                int(VALUE_TB_LOSS_IN_MAX_PLY) + 1, int(VALUE_TB_WIN_IN_MAX_PLY) - 1));
+    };
+
+    double p = pos.reds_left()  <= 0 ? 0.0
+             : pos.blues_left() <= 0 ? 1.0 : pos.captured_red_prob();
+
+    bool red = p >= 0.5;
+    double p2 = red ? 1 - p : p, p1 = 1 - p2;
+
+    if (p2 < MinChance)
+        return outcome(red, alpha, beta);
+
+    if (!PvNode)
+    {
+        const bool colour[] = { red, !red };
+        const double prob[] = { p1, p2 };
+        const double target = win_chance(beta);
+        Value lo[] = { -VALUE_INFINITE, -VALUE_INFINITE };
+        Value hi[] = {  VALUE_INFINITE,  VALUE_INFINITE };
+        Value t = beta;
+
+        // Each probe lies inside the bounds of its colour and narrows them, so
+        // the loop ends even when rounding keeps the thresholds in place
+        for (int k = 0; ; )
+        {
+            Value v = outcome(colour[k], t - 1, t);
+
+            if (Threads.stop.load(std::memory_order_relaxed))
+                return v;
+
+            if (v >= t)
+                lo[k] = v, hi[k] = std::max(hi[k], v);
+            else
+                hi[k] = v, lo[k] = std::min(lo[k], v);
+
+            double low = 0, high = 0;
+            for (int i : { 0, 1 })
+            {
+                low  += prob[i] * (lo[i] <= -VALUE_INFINITE ? 0.0 : win_chance(lo[i]));
+                high += prob[i] * (hi[i] >=  VALUE_INFINITE ? 1.0 : win_chance(hi[i]));
+            }
+
+            if (low >= target)
+                return std::max(to_value(low), beta);
+
+            if (high < target)
+                return std::min(to_value(high), alpha);
+
+            // Probe the other colour at the score that decides the node given
+            // the last bound, or this one again when the other is exact
+            int o = lo[1 - k] < hi[1 - k] ? 1 - k : k;
+            double need = (target - prob[1 - o] * win_chance(o == k ? lo[1 - k] : v)) / prob[o];
+            t = std::clamp(chance_bound(need), lo[o] + 1, hi[o]);
+            k = o;
+        }
+    }
+
+    // Star1 window of the first colour
+    Value b1 = std::clamp(chance_bound(win_chance(beta) / p1), -VALUE_INFINITE + 1, VALUE_INFINITE);
+    Value a1 = std::clamp(chance_bound((win_chance(alpha) - p2) / p1) - 1, -VALUE_INFINITE, b1 - 1);
+
+    Value v1 = outcome(red, a1, b1);
+
+    if (Threads.stop.load(std::memory_order_relaxed))
+        return v1;
+
+    double w = p1 * win_chance(v1);
+
+    if (v1 <= a1)
+        return std::min(to_value(w + p2), alpha);
+
+    if (v1 >= b1)
+        return std::max(to_value(w), beta);
+
+    // v1 is exact, the second colour is searched with the window of the node
+    double ta = (win_chance(alpha) - w) / p2, tb = (win_chance(beta) - w) / p2;
+
+    if (ta >= 1)
+        return std::min(to_value(w + p2), alpha);
+
+    if (tb <= 0)
+        return std::max(to_value(w), beta);
+
+    Value b = std::clamp(chance_bound(tb), -VALUE_INFINITE + 1, VALUE_INFINITE);
+    Value a = std::clamp(chance_bound(ta) - 1, -VALUE_INFINITE, b - 1);
+
+    Value v2 = outcome(!red, a, b);
+
+    // Two wins or two losses keep the worse mate score
+    Value v = (v1 >= VALUE_TB_WIN_IN_MAX_PLY  && v2 >= VALUE_TB_WIN_IN_MAX_PLY)
+           || (v1 <= VALUE_TB_LOSS_IN_MAX_PLY && v2 <= VALUE_TB_LOSS_IN_MAX_PLY) ? std::min(v1, v2)
+                                                                                 : to_value(w + p2 * win_chance(v2));
+
+    // Keep the bound the second search proved despite rounding
+    return v2 <= a ? std::min(v, alpha) : v2 >= b ? std::max(v, beta) : std::clamp(v, alpha, beta);
+  }
+
+
   // value_to_tt() adjusts a mate or TB score from "plies to mate from the root" to
   // "plies to mate from the current position". Standard scores are unchanged.
   // The function is called before storing a value in the transposition table.
@@ -1912,6 +2280,51 @@ namespace {
     return best;
   }
 
+  // write_telemetry() writes the record of the move just searched from 'pos',
+  // with the PV and the depth of the thread 'th' that found it.
+
+  void write_telemetry(const Position& pos, const Thread* th, const char* backend) {
+
+    std::stringstream ss;
+    const RootMove& rm = th->rootMoves[0];
+    TimePoint elapsed = Time.elapsed() + 1;
+    uint64_t nodes = Threads.nodes_searched();
+    Bitboard reds = Red::existRed ? pos.pieces(BLACK, RED) : 0;
+
+    ss << "{\"turn\":" << Red::histCnt
+       << ",\"backend\":\"" << backend << "\""
+       << ",\"depth\":" << th->completedDepth
+       << ",\"seldepth\":" << rm.selDepth
+       << ",\"score\":" << (rm.score != -VALUE_INFINITE ? rm.score : rm.previousScore)
+       << ",\"nodes\":" << nodes
+       << ",\"nps\":" << nodes * 1000 / elapsed
+       << ",\"tthit\":" << double(Threads.main()->ttHitAverage) / (TtHitAverageWindow * TtHitAverageResolution)
+       << ",\"hashfull\":" << TT.hashfull()
+       << ",\"time\":" << elapsed
+       << ",\"allotted\":" << (Limits.movetime ? Limits.movetime : Limits.use_time_management() ? Time.optimum() : 0)
+       << ",\"maximum\":" << (Limits.use_time_management() ? Time.maximum() : Limits.movetime)
+       << ",\"bestmove\":\"" << UCI::move(rm.pv[0], pos.is_chess960()) << "\""
+       << ",\"pv\":[";
+
+    for (size_t i = 0; i < rm.pv.size(); ++i)
+        ss << (i ? ",\"" : "\"") << UCI::move(rm.pv[i], pos.is_chess960()) << "\"";
+
+    ss << "],\"red\":[";
+    for (Bitboard b = reds; b; )
+    {
+        Square s = pop_lsb(&b);
+        ss << (s != lsb(reds) ? ",\"" : "\"") << UCI::square(s) << "\"";
+    }
+
+    ss << "],\"belief\":[";
+    for (int p = 0; p < Belief::PieceNum; ++p)
+        ss << (p ? "," : "") << Belief::red_prob(p);
+
+    ss << "]}";
+
+    Telemetry::write(ss.str());
+  }
+
 } // namespace
 
 
@@ -2042,7 +2455,6 @@ bool RootMove::extract_ponder_from_tt(Position& pos) {
 void Tablebases::rank_root_moves(Position& pos, Search::RootMoves& rootMoves) {
 
   RootInTB = false;
-  UseRule50 = bool(Options["Syzygy50MoveRule"]);
   ProbeDepth = int(Options["SyzygyProbeDepth"]);
   Cardinality = int(Options["SyzygyProbeLimit"]);
   bool dtz_available = true;
@@ -2056,7 +2468,7 @@ void Tablebases::rank_root_moves(Position& pos, Search::RootMoves& rootMoves) {
   }
 
   //if (Cardinality >= popcount(pos.pieces()) && !pos.can_castle(ANY_CASTLING))
-  if (Cardinality >= popcount(pos.pieces()))
+  if (Cardinality >= popcount(pos.pieces()) - pos.count<GOAL>())
   {
     // Rank moves using DTZ tables
     RootInTB = root_probe(pos, rootMoves);
@@ -86,6 +86,7 @@ struct LimitsType {
   LimitsType() { // Init explicitly due to broken value-initialization of non POD in MSVC
     time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
     movestogo = depth = mate = perft = infinite = 0;
+    mcts = chance = false;
     nodes = 0;
   }
 
@@ -94,9 +95,12 @@ struct LimitsType {
   }
 
   std::vector<Move> searchmoves;
+  std::vector<std::string> samples; // Determinized roots of a PIMC search
   TimePoint time[COLOR_NB], inc[COLOR_NB], npmsec, movetime, startTime;
   int movestogo, depth, mate, perft, infinite;
   int64_t nodes;
+  bool mcts; // Search with the information set MCTS instead of alpha-beta
+  bool chance; // Expectimax over the colours of captured unknown ghosts
 };
 
 extern LimitsType Limits;
@@ -0,0 +1,389 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// geister_server is a local stand-in for the contest's Geister game server.
+/// It listens on two ports (the first player on 'port', the second one on
+/// 'port + 1'), referees the hidden red/blue assignments and plays any
+/// number of games between the two clients that connect, so that engines
+/// can be matched on one machine without the external server:
+///
+///   ./geister_server 100 10000 &
+///   echo "100 10000 127.0.0.1" | ./stockfish &
+///   echo "100 10001 127.0.0.1" | ./stockfish
+///
+/// The protocol is the contest's one. Every line ends with CRLF.
+///
+///   server -> client  SET?                 choose the red ghosts
+///   client -> server  SET:ABCD             names of the four red ghosts
+///   server -> client  OK / NG
+///   server -> client  MOV?<board>          our turn
+///   client -> server  MOV:A,N              ghost A one step north (N/E/W/S)
+///   server -> client  ACK / NG
+///   server -> client  WON:/LST:/DRW:<board>
+///
+/// A board is 16 pieces of three characters "xyC", our ghosts A-H first and
+/// the opponent's a-h after them, in the receiver's own coordinates (its
+/// ghosts start on rows 4 and 5, the exits are at (0,0) and (5,0)). C is
+/// R/B for our ghosts and u for the opponent's ones; captured pieces are at
+/// 99 with a lower case colour, escaped ones at 88. At the end of the game
+/// the opponent's ghosts still on the board are shown as r/b.
+///
+/// Connections are kept from one game to the next, a client that has gone
+/// away is replaced by the next one to connect on its port. A client that
+/// sends a malformed or illegal message loses the game.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <cerrno>
+#include <csignal>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "referee.h"
+
+using std::string;
+using namespace Referee;
+
+namespace {
+
+#if defined(_WIN32)
+typedef uintptr_t Socket;
+#else
+typedef int Socket;
+#endif
+
+constexpr Socket InvalidSocket = Socket(~Socket(0));
+
+int64_t now() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>
+        (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void close_socket(Socket& s) {
+
+  if (s == InvalidSocket)
+      return;
+
+#ifdef _WIN32
+  closesocket(SOCKET(s));
+#else
+  ::close(s);
+#endif
+  s = InvalidSocket;
+}
+
+
+/// Connection is one client. Lines are read through a small buffer so that
+/// several messages arriving in one packet are not lost.
+
+struct Connection {
+
+  Socket s = InvalidSocket;
+  string buf;
+
+  bool is_open() const { return s != InvalidSocket; }
+
+  bool send_line(const string& line) {
+
+    string msg = line + "\r\n";
+    size_t sent = 0;
+
+    while (sent < msg.size())
+    {
+        int n = int(::send(s, msg.c_str() + sent, int(msg.size() - sent), 0));
+        if (n <= 0)
+            return false;
+        sent += size_t(n);
+    }
+    return true;
+  }
+
+  // getline() returns the next line without its CRLF, false if the client
+  // has closed the connection first.
+  bool getline(string& line) {
+
+    size_t end;
+    char chunk[256];
+
+    while ((end = buf.find('\n')) == string::npos)
+    {
+        int n = int(::recv(s, chunk, sizeof(chunk), 0));
+#ifndef _WIN32
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n <= 0)
+            return false;
+        buf.append(chunk, size_t(n));
+    }
+
+    line = buf.substr(0, end);
+    buf.erase(0, end + 1);
+
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+    return true;
+  }
+};
+
+
+/// open_listener() creates the listening socket of a player
+
+Socket open_listener(int port) {
+
+  Socket ls = Socket(socket(AF_INET, SOCK_STREAM, 0));
+  if (ls == InvalidSocket)
+      return InvalidSocket;
+
+  int one = 1;
+  setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(uint16_t(port));
+
+  if (   bind(ls, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+      || listen(ls, 1) != 0)
+  {
+      close_socket(ls);
+      return InvalidSocket;
+  }
+  return ls;
+}
+
+
+/// Match holds the two seats and the running score
+
+struct Match {
+
+  Socket listener[2] = { InvalidSocket, InvalidSocket };
+  Connection player[2];
+  int score[2][3] = {}; // [player][win, loss, draw]
+  int64_t totalPlies = 0;
+
+  // seat() makes sure that player 'p' is connected, waiting if needed
+  bool seat(int p) {
+
+    if (player[p].is_open())
+        return true;
+
+    player[p].s = Socket(accept(listener[p], nullptr, nullptr));
+    player[p].buf.clear();
+
+    if (!player[p].is_open())
+        return false;
+
+    int one = 1;
+    setsockopt(player[p].s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    std::cerr << "player " << p << " connected" << std::endl;
+    return true;
+  }
+
+  void drop(int p) {
+    close_socket(player[p].s);
+    player[p].buf.clear();
+  }
+
+  // play() runs one game with 'first' to move first and returns the winner,
+  // -1 for a draw and -2 if a player could not be seated.
+  int play(int first, int maxPlies, string& reason) {
+
+    Game game;
+    string line;
+    int loser = -1;
+
+    // Both players choose their red ghosts. A client that has gone away
+    // since the last game is replaced, a bad choice forfeits the game.
+    for (int p : { first, 1 - first })
+    {
+        while (!player[p].send_line("SET?") || !player[p].getline(line))
+        {
+            drop(p);
+            if (!seat(p))
+                return -2;
+        }
+
+        if (line.compare(0, 4, "SET:") != 0 || !game.set(p, line.substr(4)))
+        {
+            player[p].send_line("NG");
+            loser = p, reason = "bad setup " + line;
+            break;
+        }
+        player[p].send_line("OK");
+    }
+
+    Outcome outcome = NONE;
+    int us = first;
+
+    while (loser == -1 && outcome == NONE)
+    {
+        if (game.ply() >= maxPlies)
+        {
+            outcome = DRAW;
+            break;
+        }
+
+        if (   !player[us].send_line("MOV?" + game.board(us, false))
+            || !player[us].getline(line))
+        {
+            drop(us);
+            loser = us, reason = "disconnected";
+            break;
+        }
+
+        if (line.compare(0, 4, "MOV:") != 0 || !game.do_move(us, line.substr(4), outcome, reason))
+        {
+            player[us].send_line("NG");
+            loser = us, reason = "illegal move " + line;
+            break;
+        }
+
+        player[us].send_line("ACK");
+
+        if (outcome == NONE)
+            us = 1 - us;
+    }
+
+    if (outcome == DRAW)
+        reason = "ply limit";
+
+    else if (outcome != NONE)
+        loser = outcome == WIN ? 1 - us : us;
+
+    for (int p : { 0, 1 })
+        if (player[p].is_open())
+        {
+            string result = loser == -1 ? "DRW:" : loser == p ? "LST:" : "WON:";
+            if (!player[p].send_line(result + game.board(p, true)))
+                drop(p);
+        }
+
+    totalPlies += game.ply();
+    return loser == -1 ? -1 : 1 - loser;
+  }
+};
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+
+  int games    = argc > 1 ? std::atoi(argv[1]) : 1;
+  int port     = argc > 2 ? std::atoi(argv[2]) : 10000;
+  int maxPlies = argc > 3 ? std::atoi(argv[3]) : MaxPlies;
+
+#ifdef _WIN32
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 0), &data);
+#else
+  signal(SIGPIPE, SIG_IGN); // A client gone away is seen as a failed send()
+#endif
+
+  Match match;
+
+  for (int p : { 0, 1 })
+      if ((match.listener[p] = open_listener(port + p)) == InvalidSocket)
+      {
+          std::cerr << "Unable to listen on port " << port + p << std::endl;
+          return EXIT_FAILURE;
+      }
+
+  std::cerr << "geister_server: " << games << " games, ports " << port << " and "
+            << port + 1 << ", draw after " << maxPlies << " plies" << std::endl;
+
+  int64_t start = 0;
+
+  for (int n = 0; n < games; ++n)
+  {
+      for (int p : { 0, 1 })
+          if (!match.seat(p))
+          {
+              std::cerr << "Unable to accept player " << p << std::endl;
+              return EXIT_FAILURE;
+          }
+
+      if (n == 0)
+          start = now(); // Waiting for the first clients is not counted
+
+      string reason;
+      int first = n % 2; // Alternate the first move
+      int winner = match.play(first, maxPlies, reason);
+
+      if (winner == -2)
+      {
+          std::cerr << "Unable to accept a player" << std::endl;
+          return EXIT_FAILURE;
+      }
+
+      for (int p : { 0, 1 })
+          match.score[p][winner == -1 ? 2 : winner == p ? 0 : 1]++;
+
+      std::cout << "game " << n + 1 << " first " << first << " "
+                << (winner == -1 ? "draw" : "winner " + std::to_string(winner))
+                << " (" << reason << ")" << std::endl;
+  }
+
+  int64_t elapsed = now() - start + 1;
+
+  std::cout << "\n==========================="
+            << "\nGames           : " << games
+            << "\nPlayer 0 W/L/D  : " << match.score[0][0] << "/" << match.score[0][1] << "/" << match.score[0][2]
+            << "\nPlayer 1 W/L/D  : " << match.score[1][0] << "/" << match.score[1][1] << "/" << match.score[1][2]
+            << "\nTotal time (ms) : " << elapsed
+            << "\nPlies           : " << match.totalPlies
+            << "\nGames/hour      : " << std::fixed << std::setprecision(1) << 3600000.0 * games / elapsed
+            << "\nms/ply          : " << double(elapsed) / std::max(int64_t(1), match.totalPlies)
+            << std::endl;
+
+  for (int p : { 0, 1 })
+  {
+      close_socket(match.player[p].s);
+      close_socket(match.listener[p]);
+  }
+
+#ifdef _WIN32
+  WSACleanup();
+#endif
+
+  return EXIT_SUCCESS;
+}
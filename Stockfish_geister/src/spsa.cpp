@@ -0,0 +1,147 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "misc.h"
+#include "spsa.h"
+#include "tcp.h"
+#include "tune.h"
+#include "uci.h"
+
+namespace {
+
+// The gains follow the usual schedules, a_k = a / (A + k + 1)^Alpha and
+// c_k = c / (k + 1)^Gamma, with the values at the last iteration set as in
+// the lines printed by Tune: c ends at a 20th of the range, and a at REnd
+// times the square of c.
+constexpr double Alpha = 0.602;
+constexpr double Gamma = 0.101;
+constexpr double REnd  = 0.002;
+
+// Match plays the games of an iteration through tcp::selfPlay(). Before each
+// move the UCI options of the parameters are set to the values of the side
+// to move, and the score is the number of wins of side 0 minus those of
+// side 1.
+
+struct Match : public tcp::GameObserver {
+
+  std::vector<int> values[2];
+  int64_t nodes;
+  int score = 0;
+
+  explicit Match(int64_t n) : nodes(n) {}
+
+  void turn(int side) override {
+    for (size_t i = 0; i < Tune::parameters.size(); ++i)
+        Options[Tune::parameters[i].name] = std::to_string(values[side][i]);
+  }
+
+  int64_t search_nodes(const Position&, int) override { return nodes; }
+
+  void end(int winner) override {
+    score += winner == 0 ? 1 : winner == 1 ? -1 : 0;
+  }
+};
+
+} // namespace
+
+
+/// SPSA::tune() runs 'iterations' iterations of 'games' games each, searching
+/// every move for 'nodes' nodes, starting from the current values of the UCI
+/// options. The games of iteration k follow from 'seed' + k, or from the clock
+/// when 'seed' is zero. The tuned values are left in the options and printed
+/// at the end.
+
+void SPSA::tune(int iterations, int games, int64_t nodes, unsigned seed) {
+
+  const std::vector<Tune::Parameter>& params = Tune::parameters;
+
+  if (params.empty())
+  {
+      std::cerr << "No parameters to tune, build with make tune=yes" << std::endl;
+      return;
+  }
+
+  PRNG rng(seed ? seed : now());
+  std::vector<double> theta;
+  double A = 0.1 * iterations;
+
+  for (const Tune::Parameter& p : params)
+      theta.push_back(double(Options[p.name]));
+
+  // Rounds at random to one of the two nearest integers, so that the small
+  // shifts of the parameters with a narrow range are not lost
+  auto pick = [&](double x, const Tune::Parameter& p) {
+      double r = std::floor(x + double(rng.rand<uint64_t>() >> 11) / (uint64_t(1) << 53));
+      return int(std::clamp(r, double(p.min), double(p.max)));
+  };
+
+  TimePoint elapsed = now();
+
+  for (int k = 0; k < iterations; ++k)
+  {
+      Match match(nodes);
+      std::vector<double> step(params.size());
+
+      for (size_t i = 0; i < params.size(); ++i)
+      {
+          const Tune::Parameter& p = params[i];
+          double cEnd = (p.max - p.min) / 20.0;
+          double c = cEnd * std::pow(double(iterations) / (k + 1), Gamma);
+          double a = REnd * cEnd * cEnd * std::pow((A + iterations) / (A + k + 1), Alpha);
+          int delta = rng.rand<uint64_t>() & 1 ? 1 : -1;
+
+          match.values[0].push_back(pick(theta[i] + c * delta, p));
+          match.values[1].push_back(pick(theta[i] - c * delta, p));
+          step[i] = a / c * delta;
+      }
+
+      tcp::selfPlay(games, 1000, "result.txt", &match, seed ? seed + k : 0);
+
+      std::cerr << "iteration " << k + 1 << " score " << match.score;
+
+      for (size_t i = 0; i < params.size(); ++i)
+      {
+          theta[i] = std::clamp(theta[i] + step[i] * match.score,
+                                double(params[i].min), double(params[i].max));
+          std::cerr << " " << params[i].name << " " << theta[i];
+      }
+
+      std::cerr << std::endl;
+  }
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  std::cerr << "\n==========================="
+            << "\nIterations      : " << iterations
+            << "\nGames           : " << int64_t(iterations) * games
+            << "\nTotal time (ms) : " << elapsed << std::endl;
+
+  for (size_t i = 0; i < params.size(); ++i)
+  {
+      int v = int(std::lround(theta[i]));
+      Options[params[i].name] = std::to_string(v);
+      std::cerr << params[i].name << "," << v << std::endl;
+  }
+}
@@ -0,0 +1,38 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SPSA_H_INCLUDED
+#define SPSA_H_INCLUDED
+
+#include <cstdint>
+
+/// The SPSA namespace tunes the parameters registered with TUNE() (see tune.h)
+/// by simultaneous perturbation stochastic approximation: each iteration plays
+/// a few fast self-play games between two copies of the engine, one with all
+/// the parameters shifted up and one with them shifted down by random signs,
+/// and moves the parameters towards the winner. The Geister weights are only
+/// registered in a tuning build (make tune=yes).
+
+namespace SPSA {
+
+void tune(int iterations, int games, int64_t nodes, unsigned seed);
+
+} // namespace SPSA
+
+#endif // #ifndef SPSA_H_INCLUDED
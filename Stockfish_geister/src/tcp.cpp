@@ -0,0 +1,339 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "misc.h"
+#include "tcp.h"
+
+using std::string;
+
+namespace tcp {
+  Socket dstSocket = InvalidSocket;
+  Stats stats;
+}
+
+namespace {
+
+#ifdef _WIN32
+  int last_error() { return WSAGetLastError(); }
+  void close_native(tcp::Socket s) { closesocket(SOCKET(s)); }
+#else
+  int last_error() { return errno; }
+  void close_native(tcp::Socket s) { ::close(s); }
+#endif
+
+  // set_low_latency() disables Nagle's algorithm so that our short protocol
+  // lines (MOV:A,N plus CRLF) leave the machine as soon as they are written,
+  // and asks the OS to keep the connection alive between games.
+  void set_low_latency(tcp::Socket s) {
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    setsockopt(s, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&one), sizeof(one));
+  }
+
+  // LineReader splits the byte stream coming from the server into protocol
+  // lines terminated by CRLF. Whole chunks are read into a ring buffer with a
+  // single recv() and complete lines are handed out one at a time; whatever
+  // follows the last CRLF stays buffered for the next call. A board message
+  // (MOV? plus 48 characters) so costs one system call instead of ~55.
+  class LineReader {
+
+    static constexpr size_t Size = 1024; // Must be a power of 2, much longer than any line
+    static constexpr size_t Mask = Size - 1;
+
+    char buf[Size];
+    size_t head = 0, tail = 0, scanned = 0; // Free-running indices, head <= scanned <= tail
+
+  public:
+    void clear() { head = tail = scanned = 0; }
+    bool empty() const { return head == tail; }
+
+    // getline() stores the next line, CRLF included, in 'line'. It returns the
+    // line length, 0 if the connection was closed before a full line arrived
+    // (the partial line is still returned) and a negative value on error.
+    int getline(tcp::Socket s, string& line) {
+
+      line.clear();
+
+      while (true)
+      {
+          // Look for the end of a line in the data we already have
+          for ( ; scanned < tail; ++scanned)
+              if (   buf[scanned & Mask] == '\n'
+                  && scanned > head
+                  && buf[(scanned - 1) & Mask] == '\r')
+              {
+                  take(line, ++scanned);
+                  return int(line.size());
+              }
+
+          // A line that does not fit is passed on as it is
+          if (tail - head == Size)
+          {
+              take(line, tail);
+              return int(line.size());
+          }
+
+          // Read as much as fits in the contiguous free space at the tail
+          size_t free = std::min(Size - (tail - head), Size - (tail & Mask));
+          int n = tcp::recv_bytes(s, buf + (tail & Mask), int(free));
+
+          if (n <= 0)
+          {
+              take(line, tail);
+              return n;
+          }
+
+          tail += size_t(n);
+      }
+    }
+
+  private:
+    void take(string& line, size_t end) {
+      for ( ; head < end; ++head)
+          line += buf[head & Mask];
+      scanned = head;
+    }
+  };
+
+  LineReader reader;
+
+} // namespace
+
+
+/// tcp::openPort() connects to the game server. When port or dest are not
+/// given they are asked for on the console. dest may be a numeric address or
+/// a host name.
+
+bool tcp::openPort(Socket& s, int port, string dest) {
+
+#ifdef _WIN32
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 0), &data);
+#endif
+
+  // AhX̓͂Ƒ镶̓
+  if (port == -1)
+  {
+      std::cout << "|[gԍ́HF" << std::flush;
+      std::cin >> port;
+  }
+
+  if (dest.empty())
+  {
+      std::cout << "T[o[}VIṔH:" << std::flush;
+      std::cin >> dest;
+  }
+
+  addrinfo hints, *res = nullptr;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo(dest.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || !res)
+  {
+      std::cout << dest << "@ɐڑł܂ł" << std::endl;
+      return false;
+  }
+
+  s = Socket(socket(res->ai_family, res->ai_socktype, res->ai_protocol));
+
+  if (!is_open(s) || connect(s, res->ai_addr, int(res->ai_addrlen)) != 0)
+  {
+      std::cout << last_error() << std::endl;
+      std::cout << dest << "@ɐڑł܂ł" << std::endl;
+      freeaddrinfo(res);
+      closePort(s);
+      return false;
+  }
+
+  freeaddrinfo(res);
+  set_low_latency(s);
+
+  std::cout << dest << " ɐڑ܂" << std::endl;
+  return true;
+}
+
+
+/// tcp::closePort() shuts the connection down and marks the handle as invalid
+
+void tcp::closePort(Socket& s) {
+
+  if (is_open(s))
+      close_native(s);
+
+  s = InvalidSocket;
+  reader.clear();
+
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+
+/// tcp::send_bytes() and tcp::recv_bytes() are the only raw I/O entry points.
+/// They return the number of bytes transferred, 0 when the peer has closed
+/// the connection and a negative value on error.
+
+int tcp::send_bytes(Socket s, const char* buf, int len) {
+
+  int sent = 0;
+
+  while (sent < len)
+  {
+      int n = int(::send(s, buf + sent, len - sent, 0));
+      stats.sendCalls++;
+      if (n <= 0)
+          return n;
+      sent += n;
+      stats.bytesSent += n;
+  }
+  return sent;
+}
+
+int tcp::recv_bytes(Socket s, char* buf, int len) {
+
+  int n;
+
+  do {
+      n = int(::recv(s, buf, len, 0));
+      stats.recvCalls++;
+  }
+#ifndef _WIN32
+  while (n < 0 && errno == EINTR);
+#else
+  while (false);
+#endif
+
+  if (n > 0)
+      stats.bytesRecv += n;
+
+  return n;
+}
+
+
+/// tcp::wait_message() waits up to 'ms' milliseconds for the server to send
+/// something on an already open connection. It returns false on timeout or if
+/// the server has closed the connection, so that the game loop can reuse a
+/// live connection for the next game and reconnect otherwise.
+
+bool tcp::wait_message(Socket s, int ms) {
+
+  if (!is_open(s))
+      return false;
+
+  if (!reader.empty())
+      return true;
+
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  FD_SET(s, &readSet);
+
+  timeval tv;
+  tv.tv_sec = ms / 1000;
+  tv.tv_usec = (ms % 1000) * 1000;
+
+  if (select(int(s) + 1, &readSet, nullptr, nullptr, &tv) <= 0)
+      return false;
+
+  char c;
+  return ::recv(s, &c, 1, MSG_PEEK) > 0;
+}
+
+
+/// tcp::sleep() pauses the calling thread, e.g. before reconnecting
+
+void tcp::sleep(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+
+/// tcp::reset_stats() and tcp::stats_str() clear and format the I/O counters
+
+void tcp::reset_stats() {
+  stats = Stats();
+}
+
+string tcp::stats_str() {
+
+  std::stringstream ss;
+
+  ss << "recv " << stats.bytesRecv << " bytes / " << stats.recvCalls << " calls, "
+     << "send " << stats.bytesSent << " bytes / " << stats.sendCalls << " calls";
+
+  return ss.str();
+}
+
+
+void tcp::mySend(Socket s, string str) {
+
+  if (str.length() == 0) {	//nullȂúv󂯕t
+    std::cin >> str;
+  }
+  if (str.length() < 2 || str[str.length() - 2] != '\r' || str[str.length() - 1] != '\n') {	//\r\nɂȂΒǉ
+    str += '\r';
+    str += '\n';
+  }
+  int byte = send_bytes(s, str.c_str(), int(str.length()));	//𑗐M
+  sync_cout << str << sync_endl;
+  if (byte <= 0) {
+    std::cout << "MG[" << std::endl;
+  }
+}
+
+string tcp::myRecv(Socket s) {
+
+  string msg;
+
+  //\r\n܂ł1sM (̓obt@Ɏc)
+  if (reader.getline(s, msg) < 0) { std::cout << "MɎs܂" << std::endl; return msg; }
+
+  std::cout << "M = " << msg << std::endl;
+
+  return msg;
+}
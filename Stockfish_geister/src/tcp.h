@@ -1,97 +1,96 @@
-#pragma once
-#pragma comment(lib, "wsock32.lib")
-#include <stdio.h>
-#include <string.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <iostream>
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TCP_H_INCLUDED
+#define TCP_H_INCLUDED
+
+#include <cstdint>
 #include <string>
 
+#include "types.h"
+
+class Position;
+
+/// The tcp namespace is the thin, portable socket layer used to talk to the
+/// Geister game server. Winsock is used on Windows and BSD sockets everywhere
+/// else; the game loop only sees a tcp::Socket handle and the functions below,
+/// so the protocol code (SET:, MOV?, MOV:X,N, ACK, WON/LST/DRW) is shared.
+
 namespace tcp {
-	void mySend(int dstSocket, std::string str = "")
-	{
-		if (str.length() == 0) {	//nullȂúv󂯕t
-			std::cin >> str;
-		}
-		if (str.length() < 2 || str[str.length() - 2] != '\r' || str[str.length() - 1] != '\n') {	//\r\nɂȂΒǉ
-			str += '\r';
-			str += '\n';
-		}
-		int byte = send(dstSocket, str.c_str(), str.length(), 0);	//𑗐M
-		if (byte <= 0) {
-			std::cout << "MG[" << std::endl;
-		}
-	}
-
-	std::string myRecv(int dstSocket)
-	{
-		char buffer[10];
-		std::string msg;
-		
-		do {
-			int byte = recv(dstSocket, buffer, 1, 0);	//M
-			
-			if (byte == 0) break;
-			if (byte < 0) { std::cout << "MɎs܂" << std::endl; return msg; }
-			
-			msg += buffer[0];
-		} while (msg.length() < 2 || msg[msg.length() - 2] != '\r' || msg[msg.length() - 1] != '\n');
-		
-		std::cout << "M = " << msg << std::endl;
-		
-		return msg;
-	}
-
-	bool openPort(int &dstSocket, int port = -1, std::string dest = "")
-	{
-		// IP AhXC|[gԍC\PbgCsockaddr_in \
-		char destination[32];
-		struct sockaddr_in dstAddr;
-		int PORT;
-		
-		// Windows ̏ꍇ
-		WSADATA data;
-		WSAStartup(MAKEWORD(2,0), &data);
-
-		// AhX̓͂Ƒ镶̓
-		if (port == -1) {
-			printf("|[gԍ́HF");
-			scanf("%d", &PORT);
-		} else {
-			PORT = port;
-		}
-		
-		if (dest.length() == 0) {
-			printf("T[o[}VIṔH:");
-			scanf("%s", destination);
-		} else {
-			for (int i = 0; i < dest.size(); i++) destination[i] = dest[i];
-			destination[dest.size()] = '\0';
-		}
-		
-		// sockaddr_in \̂̃Zbg
-		memset(&dstAddr, 0, sizeof(dstAddr));
-		dstAddr.sin_port = htons(PORT);
-		dstAddr.sin_family = AF_INET;
-		dstAddr.sin_addr.s_addr = inet_addr(destination);
-
-		// \Pbg̐
-		dstSocket = socket(AF_INET, SOCK_STREAM, 0);
-
-		//ڑ
-		if(connect(dstSocket, (struct sockaddr *) &dstAddr, sizeof(dstAddr))){
-			printf("%s@ɐڑł܂ł\n",destination);
-			return false;
-		}
-	  	printf("%s ɐڑ܂\n", destination);
-
-		return true;
-	}
-
-	void closePort(int &dstSocket)
-	{
-		// Windows ł̃\Pbg̏I
-		closesocket(dstSocket);
-		WSACleanup();
-	}
-}
\ No newline at end of file
+
+#if defined(_WIN32)
+typedef uintptr_t Socket; // Same width as Winsock SOCKET
+#else
+typedef int Socket;
+#endif
+
+constexpr Socket InvalidSocket = Socket(~Socket(0));
+
+extern Socket dstSocket;
+
+/// Stats counts the traffic and the number of send()/recv() system calls.
+/// It is reset at the start of every game so that the cost of the protocol
+/// handling can be read off per game.
+
+struct Stats {
+  uint64_t bytesSent, bytesRecv;
+  uint64_t sendCalls, recvCalls;
+};
+
+extern Stats stats;
+
+// Low level connection handling
+bool openPort(Socket& s, int port = -1, std::string dest = "");
+void closePort(Socket& s);
+inline bool is_open(Socket s) { return s != InvalidSocket; }
+int send_bytes(Socket s, const char* buf, int len);
+int recv_bytes(Socket s, char* buf, int len);
+bool wait_message(Socket s, int ms);
+void sleep(int ms);
+void reset_stats();
+std::string stats_str();
+
+// Geister protocol
+void mySend(Socket s, std::string str = "");
+std::string myRecv(Socket s);
+std::string MoveStr(Move mv);
+
+/// GameObserver is told about the games played by selfPlay(), e.g. to build
+/// an opening book from them. Sides are 0 and 1 as in result.txt; 'pos' is the
+/// position as seen by the side to move, and the winner is -1 for a draw.
+/// turn() is called before each move, e.g. to give the sides different
+/// parameters. move() also gets the score of the search and the board string
+/// of the side to move with the colours of the opponent's ghosts revealed.
+
+struct GameObserver {
+  virtual ~GameObserver() = default;
+  virtual void start(const std::string& /*reds0*/, const std::string& /*reds1*/) {}
+  virtual void turn(int /*side*/) {}
+  virtual int search_time(const Position&, int /*side*/) { return 0; } // 0 for the game clock
+  virtual int64_t search_nodes(const Position&, int /*side*/) { return 0; } // 0 for no limit
+  virtual void move(const Position&, int /*side*/, Move, Value /*score*/, const std::string& /*board*/) {}
+  virtual void end(int /*winner*/) {}
+};
+
+int playGame(int n, int port = -1, std::string destination = "");
+void selfPlay(int n, int movetime = 1000, std::string filename = "result.txt",
+              GameObserver* observer = nullptr, unsigned seed = 0);
+
+} // namespace tcp
+
+#endif // #ifndef TCP_H_INCLUDED
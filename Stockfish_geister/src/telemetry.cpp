@@ -0,0 +1,164 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "misc.h"
+#include "telemetry.h"
+
+namespace {
+
+constexpr size_t MaxQueued = 4096; // Lines waiting for the writer
+
+// Writer owns the telemetry file and the thread that writes to it. write()
+// only appends to the queue under the mutex; the writer thread takes all the
+// queued lines at once and does the I/O without holding it.
+
+class Writer {
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::string> queue;
+  std::ofstream file;
+  std::thread thread;
+  bool exit = false;
+  std::atomic_bool open { false };
+  uint64_t dropped = 0;
+
+  void loop() {
+
+    std::deque<std::string> lines;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&]{ return exit || !queue.empty(); });
+
+            if (queue.empty())
+                return; // Exit with nothing left to write
+
+            lines.swap(queue);
+        }
+
+        for (const std::string& l : lines)
+            file << l << '\n';
+
+        file.flush();
+        lines.clear();
+    }
+  }
+
+public:
+  ~Writer() { close(); }
+
+  bool is_open() const { return open; }
+
+  void start(const std::string& path) {
+
+    file.open(path, std::ios::out | std::ios::app);
+
+    if (!file.is_open())
+    {
+        sync_cout << "info string Could not open telemetry file " << path << sync_endl;
+        return;
+    }
+
+    exit = false;
+    dropped = 0;
+    thread = std::thread(&Writer::loop, this);
+    open = true;
+  }
+
+  // close() writes out the queued lines and stops the thread
+  void close() {
+
+    if (!open)
+        return;
+
+    open = false;
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        exit = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+    file.close();
+
+    if (dropped)
+        std::cerr << "Telemetry: " << dropped << " records dropped" << std::endl;
+  }
+
+  void push(std::string line) {
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+
+        if (queue.size() >= MaxQueued)
+        {
+            dropped++;
+            return;
+        }
+
+        queue.push_back(std::move(line));
+    }
+
+    cv.notify_one();
+  }
+};
+
+Writer writer;
+
+} // namespace
+
+
+/// Telemetry::init() closes the current telemetry file, if any, and appends
+/// to the one at 'path'. An empty path or "<empty>" switches telemetry off.
+
+void Telemetry::init(const std::string& path) {
+
+  writer.close();
+
+  if (!path.empty() && path != "<empty>")
+      writer.start(path);
+}
+
+
+/// Telemetry::enabled() tells whether records are written, so that callers
+/// do not build them for nothing.
+
+bool Telemetry::enabled() {
+  return writer.is_open();
+}
+
+
+/// Telemetry::write() queues a record, a JSON object on a single line.
+
+void Telemetry::write(std::string line) {
+
+  if (writer.is_open())
+      writer.push(std::move(line));
+}
@@ -0,0 +1,38 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2020 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TELEMETRY_H_INCLUDED
+#define TELEMETRY_H_INCLUDED
+
+#include <string>
+
+/// The Telemetry namespace writes one JSON object per line (JSON Lines) to the
+/// file of the "Telemetry File" option, one record per searched move. Lines
+/// are handed to a writer thread through a bounded queue, so the search never
+/// waits for the disk: when the queue is full the record is dropped and
+/// counted instead.
+
+namespace Telemetry {
+
+void init(const std::string& path);
+bool enabled();
+void write(std::string line);
+
+} // namespace Telemetry
+
+#endif // #ifndef TELEMETRY_H_INCLUDED
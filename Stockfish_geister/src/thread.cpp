@@ -19,6 +19,7 @@
 #include <cassert>
 
 #include <algorithm> // For std::count
+#include "belief.h"
 #include "movegen.h"
 #include "search.h"
 #include "thread.h"
@@ -162,6 +163,25 @@ void ThreadPool::clear() {
 }
 
 
+/// MainThread::wait_for_stop() blocks the main thread, once it is done with a
+/// ponder or infinite search, until it is told to stop or the ponder search
+/// becomes a normal one. Whoever sets Threads.stop or clears 'ponder' from
+/// another thread calls wake_up() afterwards. The predicate is checked under
+/// the mutex, so a wake_up() can not slip in between the check and the wait.
+
+void MainThread::wait_for_stop() {
+
+  std::unique_lock<std::mutex> lk(waitMutex);
+  waitCv.wait(lk, [&]{ return Threads.stop || !(ponder || Search::Limits.infinite); });
+}
+
+void MainThread::wake_up() {
+
+  std::lock_guard<std::mutex> lk(waitMutex);
+  waitCv.notify_one();
+}
+
+
 /// ThreadPool::start_thinking() wakes up main thread waiting in idle_loop() and
 /// returns immediately. Main thread will wake up other threads and start the search.
 
@@ -198,11 +218,14 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   // since they are read-only.
   for (Thread* th : *this)
   {
-      th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = 0;
+      th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = th->iterations = 0;
       th->rootDepth = th->completedDepth = 0;
       th->rootMoves = rootMoves;
       th->rootPos.set(pos.fen(), pos.is_chess960(), &th->rootState, th);
       th->rootState = setupStates->back();
+      if (Eval::useNNUE)
+          th->rootPos.attach(th->accumulators);
+      Belief::set_red_probs(th->rootPos);
   }
 
   main()->start_searching();
@@ -240,6 +263,33 @@ Thread* ThreadPool::get_best_thread() const {
 }
 
 
+/// ThreadPool::set_samples() gives every thread one of the determinized roots
+/// of a PIMC search, starting with sample 'first', and resets the per search
+/// data so that each sample is searched from scratch.
+
+void ThreadPool::set_samples(size_t first) {
+
+  const auto& samples = Search::Limits.samples;
+  Search::RootMoves rootMoves;
+
+  for (const auto& rm : main()->rootMoves)
+      rootMoves.emplace_back(rm.pv[0]);
+
+  for (size_t i = 0; i < size(); ++i)
+  {
+      Thread* th = (*this)[i];
+      th->rootDepth = th->completedDepth = th->nmpMinPly = th->bestMoveChanges = 0;
+      th->rootMoves = rootMoves;
+      th->rootPos.set(samples[(first + i) % samples.size()], false, &th->rootState, th);
+      if (Eval::useNNUE)
+          th->rootPos.attach(th->accumulators);
+  }
+
+  stop = false;
+  increaseDepth = true;
+}
+
+
 /// Start non-main threads
 
 void ThreadPool::start_searching() {
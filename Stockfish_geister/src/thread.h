@@ -26,7 +26,9 @@
 #include <vector>
 
 #include "material.h"
+#include "mcts.h"
 #include "movepick.h"
+#include "nnue/nnue_accumulator.h"
 //#include "pawns.h"
 #include "position.h"
 #include "search.h"
@@ -61,10 +63,12 @@ public:
   uint64_t ttHitAverage;
   int selDepth, nmpMinPly;
   Color nmpColor;
-  std::atomic<uint64_t> nodes, tbHits, bestMoveChanges;
+  std::atomic<uint64_t> nodes, tbHits, bestMoveChanges, iterations;
+  MCTS::NodePool nodePool;
 
   Position rootPos;
   StateInfo rootState;
+  Eval::NNUE::Accumulator accumulators[Eval::NNUE::kAccumulatorStackSize];
   Search::RootMoves rootMoves;
   Depth rootDepth, completedDepth;
   CounterMoveHistory counterMoves;
@@ -83,14 +87,23 @@ struct MainThread : public Thread {
   using Thread::Thread;
 
   void search() override;
+  void search_samples();
+  void search_mcts();
   void check_time();
+  void wait_for_stop();
+  void wake_up();
 
   double previousTimeReduction;
   Value bestPreviousScore;
+  Move bestMove;
   Value iterValue[4];
   int callsCnt;
   bool stopOnPonderhit;
   std::atomic_bool ponder;
+
+private:
+  std::mutex waitMutex;
+  std::condition_variable waitCv;
 };
 
 
@@ -107,7 +120,9 @@ struct ThreadPool : public std::vector<Thread*> {
   MainThread* main()        const { return static_cast<MainThread*>(front()); }
   uint64_t nodes_searched() const { return accumulate(&Thread::nodes); }
   uint64_t tb_hits()        const { return accumulate(&Thread::tbHits); }
+  uint64_t iterations_searched() const { return accumulate(&Thread::iterations); }
   Thread* get_best_thread() const;
+  void set_samples(size_t first);
   void start_searching();
   void wait_for_search_finished() const;
 
@@ -20,19 +20,85 @@
 #include <cfloat>
 #include <cmath>
 
+#include "bitboard.h"
+#include "movegen.h"
+#include "position.h"
 #include "search.h"
 #include "timeman.h"
 #include "uci.h"
 
 TimeManagement Time; // Our global time management object
 
+namespace {
+
+  // Critical positions, where a ghost is about to escape, get this much more
+  // time than the others
+  constexpr double CriticalScale = 1.5;
+
+  Bitboard exits(Color c) {
+    return c == WHITE ? SQ_A1 | SQ_F1 : SQ_A6 | SQ_F6;
+  }
+
+  Bitboard near_exits(Color c) {
+    Bitboard b = exits(c);
+    return b | PseudoAttacks[RED][lsb(b)] | PseudoAttacks[RED][msb(b)];
+  }
+
+  // Ghosts of 'c' that may escape: blues and, for the opponent, the ghosts
+  // of unknown colour, which the search treats as blue when a red is marked
+  Bitboard runners(const Position& pos, Color c) {
+    return pos.pieces(c, BLUE) | pos.pieces(c, PURPLE);
+  }
+
+  // critical() is true when one of our blues or one of the opponent's possible
+  // blues stands on or next to its exits.
+  bool critical(const Position& pos) {
+
+    Color us = pos.side_to_move();
+
+    return   (pos.pieces(us, BLUE) & near_exits(us))
+          || (runners(pos, ~us) & near_exits(~us));
+  }
+
+  // forced_move() returns the move to play without thinking, if there is one:
+  // the escape of one of our blues standing on an exit, or the only capture
+  // of an opponent's possible blue that would escape on its next move.
+  Move forced_move(const Position& pos) {
+
+    Color us = pos.side_to_move();
+    Bitboard escapes = pos.pieces(us, BLUE) & exits(us);
+    Bitboard threats = runners(pos, ~us) & exits(~us);
+    Move only = MOVE_NONE;
+    int captures = 0;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        if ((escapes & from_sq(m)) && pos.piece_on(to_sq(m)) == make_piece(~us, GOAL))
+            return m;
+
+        if (threats & to_sq(m))
+            only = m, captures++;
+    }
+
+    return captures == 1 ? only : MOVE_NONE;
+  }
+
+} // namespace
+
 
 /// TimeManagement::init() is called at the beginning of the search and calculates
 /// the bounds of time allowed for the current game ply. We currently support:
 //      1) x basetime (+ z increment)
 //      2) x moves in y seconds (+ z increment)
+//      3) the Geister game clock, which is 2) with the time left for the game
+//         and our moves left before the ply cap
+/// Critical positions get more time, and a move that has to be played anyway
+/// is kept in onlyMove for the search to stop at once when it is the best.
 
-void TimeManagement::init(Search::LimitsType& limits, Color us, int ply) {
+void TimeManagement::init(Search::LimitsType& limits, const Position& pos) {
+
+  Color us = pos.side_to_move();
+  int ply = pos.game_ply();
 
   TimePoint moveOverhead    = TimePoint(Options["Move Overhead"]);
   TimePoint slowMover       = TimePoint(Options["Slow Mover"]);
@@ -58,6 +124,7 @@ void TimeManagement::init(Search::LimitsType& limits, Color us, int ply) {
   }
 
   startTime = limits.startTime;
+  onlyMove = limits.use_time_management() ? forced_move(pos) : MOVE_NONE;
 
   // Maximum move horizon of 50 moves
   int mtg = limits.movestogo ? std::min(limits.movestogo, 50) : 50;
@@ -88,6 +155,9 @@ void TimeManagement::init(Search::LimitsType& limits, Color us, int ply) {
       maxScale = std::min(6.3, 1.5 + 0.11 * mtg);
   }
 
+  if (critical(pos))
+      optScale *= CriticalScale;
+
   // Never use more than 80% of the available time for this move
   optimumTime = TimePoint(optScale * timeLeft);
   maximumTime = TimePoint(std::min(0.8 * limits.time[us] - moveOverhead, maxScale * optimumTime));
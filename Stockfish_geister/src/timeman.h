@@ -23,14 +23,17 @@
 #include "search.h"
 #include "thread.h"
 
+class Position;
+
 /// The TimeManagement class computes the optimal time to think depending on
 /// the maximum available time, the game move number and other parameters.
 
 class TimeManagement {
 public:
-  void init(Search::LimitsType& limits, Color us, int ply);
+  void init(Search::LimitsType& limits, const Position& pos);
   TimePoint optimum() const { return optimumTime; }
   TimePoint maximum() const { return maximumTime; }
+  Move only_move() const { return onlyMove; }
   TimePoint elapsed() const { return Search::Limits.npmsec ?
                                      TimePoint(Threads.nodes_searched()) : now() - startTime; }
 
@@ -40,6 +43,7 @@ private:
   TimePoint startTime;
   TimePoint optimumTime;
   TimePoint maximumTime;
+  Move onlyMove;
 };
 
 extern TimeManagement Time;
@@ -27,6 +27,7 @@
 using std::string;
 
 bool Tune::update_on_last;
+std::vector<Tune::Parameter> Tune::parameters;
 const UCI::Option* LastOption = nullptr;
 BoolConditions Conditions;
 static std::map<std::string, int> TuneResults;
@@ -67,6 +68,7 @@ static void make_option(const string& n, int v, const SetRange& r) {
 
   Options[n] << UCI::Option(v, r(v).first, r(v).second, on_tune);
   LastOption = &Options[n];
+  Tune::parameters.push_back({ n, r(v).first, r(v).second });
 
   // Print formatted parameters, ready to be copy-pasted in Fishtest
   std::cout << n << ","
@@ -175,6 +175,10 @@ public:
   static void init() { for (auto& e : instance().list) e->init_option(); read_options(); } // Deferred, due to UCI::Options access
   static void read_options() { for (auto& e : instance().list) e->read_option(); }
   static bool update_on_last;
+
+  // The UCI options of the tuned integers with their ranges, for the tuners
+  struct Parameter { std::string name; int min, max; };
+  static std::vector<Parameter> parameters;
 };
 
 // Some macro magic :-) we define a dummy int variable that compiler initializes calling Tune::add()
@@ -180,9 +180,6 @@ enum Value : int {
   VALUE_TB_LOSS_IN_MAX_PLY = -VALUE_TB_WIN_IN_MAX_PLY,
   VALUE_MATE_IN_MAX_PLY  =  VALUE_MATE - MAX_PLY,
   VALUE_MATED_IN_MAX_PLY = -VALUE_MATE_IN_MAX_PLY,
-  
-  ExistWeight = 1000,
-  DistWeight = 1,
 
   RePawnValueMg = 126, RePawnValueEg = 208,
   ReRookValueMg = 1276, ReRookValueEg = 1380,
@@ -242,25 +239,24 @@ enum : int {
   DEPTH_OFFSET = -7 // value used only for TT entry occupancy check
 };
 
-//6*6g
-//āFオ, E͓
+//6*6̃}XMW (x, y) ̏ y * 6 + x ŕׁǍɃS[(Eo)4}Xu
+//() y = 5 ̑ɂ. SQ_A0, SQ_F0  y = -1 (̃S[), SQ_A7, SQ_F7  y = 6 (̃S[)
 enum Square : int {
-  SQ_A1, SQ_B1, SQ_C1, SQ_D1, SQ_E1, SQ_F1, SQ_G1, SQ_H1,
-  SQ_A2, SQ_B2, SQ_C2, SQ_D2, SQ_E2, SQ_F2, SQ_G2, SQ_H2,
-  SQ_A3, SQ_B3, SQ_C3, SQ_D3, SQ_E3, SQ_F3, SQ_G3, SQ_H3,
-  SQ_A4, SQ_B4, SQ_C4, SQ_D4, SQ_E4, SQ_F4, SQ_G4, SQ_H4,
-  SQ_A5, SQ_B5, SQ_C5, SQ_D5, SQ_E5, SQ_F5, SQ_G5, SQ_H5,
-  SQ_A6, SQ_B6, SQ_C6, SQ_D6, SQ_E6, SQ_F6, SQ_G6, SQ_H6,
-  SQ_A7, SQ_B7, SQ_C7, SQ_D7, SQ_E7, SQ_F7, SQ_G7, SQ_H7,
-  SQ_A8, SQ_B8, SQ_C8, SQ_D8, SQ_E8, SQ_F8, SQ_G8, SQ_H8,
+  SQ_A1, SQ_B1, SQ_C1, SQ_D1, SQ_E1, SQ_F1,
+  SQ_A2, SQ_B2, SQ_C2, SQ_D2, SQ_E2, SQ_F2,
+  SQ_A3, SQ_B3, SQ_C3, SQ_D3, SQ_E3, SQ_F3,
+  SQ_A4, SQ_B4, SQ_C4, SQ_D4, SQ_E4, SQ_F4,
+  SQ_A5, SQ_B5, SQ_C5, SQ_D5, SQ_E5, SQ_F5,
+  SQ_A6, SQ_B6, SQ_C6, SQ_D6, SQ_E6, SQ_F6,
+  SQ_A0, SQ_F0, SQ_A7, SQ_F7,
   SQ_NONE,
 
   SQUARE_ZERO = 0,
-  SQUARE_NB   = 64
+  SQUARE_NB   = 40
 };
 
 enum Direction : int {
-  NORTH =  8,
+  NORTH =  6,
   EAST  =  1,
   SOUTH = -NORTH,
   WEST  = -EAST,
@@ -272,11 +268,12 @@ enum Direction : int {
 };
 
 enum File : int {
-  FILE_A, FILE_B, FILE_C, FILE_D, FILE_E, FILE_F, FILE_G, FILE_H, FILE_NB
+  FILE_A, FILE_B, FILE_C, FILE_D, FILE_E, FILE_F, FILE_NB
 };
 
+//RANK_0  RANK_7 ͔ՊÕS[̒i
 enum Rank : int {
-  RANK_1, RANK_2, RANK_3, RANK_4, RANK_5, RANK_6, RANK_7, RANK_8, RANK_NB
+  RANK_0 = -1, RANK_1, RANK_2, RANK_3, RANK_4, RANK_5, RANK_6, RANK_7, RANK_NB = RANK_7
 };
 
 // Keep track of what a move changes on the board (used by NNUE)
@@ -389,12 +386,12 @@ constexpr Color operator~(Color c) {
   return Color(c ^ BLACK); // Toggle color
 }
 
-constexpr Square flip_rank(Square s) { // Swap A1 <-> A8
-  return Square(s ^ SQ_A8);
+constexpr Square flip_rank(Square s) { // Swap A1 <-> A6, A0 <-> A7
+  return s <= SQ_F6 ? Square(SQ_A6 - s / 6 * 6 + s % 6) : Square(s ^ 2);
 }
 
-constexpr Square flip_file(Square s) { // Swap A1 <-> H1
-  return Square(s ^ SQ_H1);
+constexpr Square flip_file(Square s) { // Swap A1 <-> F1, A0 <-> F0
+  return s <= SQ_F6 ? Square(s + FILE_F - 2 * (s % 6)) : Square(s ^ 1);
 }
 
 constexpr Piece operator~(Piece pc) {
@@ -415,8 +412,11 @@ constexpr Value mated_in(int ply) {
   return -VALUE_MATE + ply;
 }
 
+//S[̒iłAF񂾂}XɂȂ
 constexpr Square make_square(File f, Rank r) {
-  return Square((r << 3) + f);
+  return r >= RANK_1 && r <= RANK_6 ? Square(r * 6 + f)
+       : f == FILE_A || f == FILE_F ? Square(SQ_A0 + 2 * (r == RANK_7) + (f == FILE_F))
+       : SQ_NONE;
 }
 
 constexpr Piece make_piece(Color c, PieceType pt) {
@@ -434,32 +434,31 @@ inline Color color_of(Piece pc) {
 
 //prړł͂Ȃ̂Ŏc
 constexpr bool is_ok(Square s) {
-  return s >= SQ_A1 && s <= SQ_H8;
+  return s >= SQ_A1 && s <= SQ_F7;
 }
 //6*6ƃS[
 constexpr bool is_ok_B(Square s) {
-  return (s == SQ_B1 || s == SQ_B8 || s == SQ_G1 || s == SQ_G8 || s == SQ_A1 || s == SQ_A8 || s == SQ_H1 || s == SQ_H8)
-    || (s >= SQ_B2 && s <= SQ_G7 && (s & 7) != 0 && (s & 7) != 7);
+  return is_ok(s);
 }
 //6*6
 constexpr bool is_ok_R(Square s) {
-  return (s >= SQ_B2 && s <= SQ_G7 && (s & 7) != 0 && (s & 7) != 7);
+  return s >= SQ_A1 && s <= SQ_F6;
 }
 
 constexpr File file_of(Square s) {
-  return File(s & 7);
+  return s <= SQ_F6 ? File(s % 6) : File(FILE_F * (s & 1));
 }
 
 constexpr Rank rank_of(Square s) {
-  return Rank(s >> 3);
+  return s <= SQ_F6 ? Rank(s / 6) : s <= SQ_F0 ? RANK_0 : RANK_7;
 }
 
 constexpr Square relative_square(Color c, Square s) {
-  return Square(s ^ (c * 56));
+  return c == WHITE ? s : flip_rank(s);
 }
 
 constexpr Rank relative_rank(Color c, Rank r) {
-  return Rank(r ^ (c * 7));
+  return c == WHITE ? r : Rank(RANK_6 - r);
 }
 
 constexpr Rank relative_rank(Color c, Square s) {
@@ -478,8 +477,10 @@ constexpr Square to_sq(Move m) {
   return Square(m & 0x3F);
 }
 
+// from_to() is the index of a move in the butterfly tables, which have
+// SQUARE_NB * SQUARE_NB entries while the move keeps its squares in 6 bits each
 constexpr int from_to(Move m) {
- return m & 0xFFF;
+  return from_sq(m) * SQUARE_NB + to_sq(m);
 }
 
 constexpr MoveType type_of(Move m) {
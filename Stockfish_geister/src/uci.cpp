@@ -19,26 +19,28 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <fstream>
 #include <ctime>
 
+#include "belief.h"
+#include "book.h"
+#include "datagen.h"
 #include "evaluate.h"
 #include "movegen.h"
 #include "position.h"
 #include "search.h"
+#include "spsa.h"
 #include "thread.h"
 #include "timeman.h"
 #include "tt.h"
 #include "uci.h"
 #include "syzygy/tbprobe.h"
-
-#define NOMINMAX
-#pragma comment(lib, "ws2_32.lib")
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "tcp.h"
+#include "referee.h"
 
 #include "types.h"
 #include "Game_geister.h"
@@ -101,30 +103,51 @@ namespace {
     //Eval::NNUE::verify();
 
     //sync_cout << "\n" << Eval::trace(p) << sync_endl;
+
+    if (Eval::useNNUE)
+        sync_cout << "NNUE evaluation: " << Eval::NNUE::evaluate(p) << " (side to move)" << sync_endl;
+
+    sync_cout << "Final evaluation: " << Eval::evaluate_P(p, 0) << " (side to move)" << sync_endl;
   }
 
+  // eval_speed() runs the "evals" limit type of bench, a throughput test of
+  // the leaf evaluation: it evaluates the positions two plies from 'pos',
+  // the leaves of a shallow search, 'reps' times each and returns the number
+  // of evaluations.
 
-  // setoption() is called when engine receives the "setoption" UCI command. The
-  // function updates the UCI option ("name") to the given value ("value").
+  uint64_t eval_speed(const Position& pos, int reps) {
 
-  void setoption(istringstream& is) {
+    std::deque<StateInfo> states(1);
+    std::deque<Position> leaves;
+    Position p;
+    StateInfo st[2];
 
-    string token, name, value;
+    p.set(pos.fen(), false, &states.back(), Threads.main());
 
-    is >> token; // Consume "name" token
+    for (const auto& m1 : MoveList<LEGAL>(p))
+    {
+        p.do_move(m1, st[0]);
 
-    // Read option name (can contain spaces)
-    while (is >> token && token != "value")
-        name += (name.empty() ? "" : " ") + token;
+        for (const auto& m2 : MoveList<LEGAL>(p))
+        {
+            p.do_move(m2, st[1]);
+            states.emplace_back();
+            leaves.emplace_back().set(p.fen(), false, &states.back(), Threads.main());
+            p.undo_move(m2);
+        }
 
-    // Read option value (can contain spaces)
-    while (is >> token)
-        value += (value.empty() ? "" : " ") + token;
+        p.undo_move(m1);
+    }
 
-    if (Options.count(name))
-        Options[name] = value;
-    else
-        sync_cout << "No such option: " << name << sync_endl;
+    int64_t sum = 0;
+
+    for (int i = 0; i < reps; ++i)
+        for (const Position& leaf : leaves)
+            sum += Eval::evaluate_P(leaf, 0);
+
+    sync_cout << "info string evals leaves " << leaves.size() << " sum " << sum << sync_endl;
+
+    return uint64_t(reps) * leaves.size();
   }
 
 
@@ -158,10 +181,164 @@ namespace {
         else if (token == "infinite")  limits.infinite = 1;
         else if (token == "ponder")    ponderMode = true;
 
+    limits.mcts = Options["Search"] == "ISMCTS";
+    limits.chance = Options["Chance Nodes"];
+
     Threads.start_thinking(pos, states, limits, ponderMode);
   }
 
 
+  // perft() is called when engine receives the "perft" command. It is a
+  // shortcut for "position fen <board>" plus "go perft <depth>" that can be
+  // given on the command line, e.g. "./stockfish perft 6 MOV?14R24R...". The
+  // current position is used when no board follows the depth.
+
+  void perft(Position& pos, istringstream& is, StateListPtr& states) {
+
+    string depth, token, fen;
+
+    is >> depth;
+
+    while (is >> token)
+        fen += token + " ";
+
+    if (!fen.empty())
+    {
+        istringstream ss("fen " + fen);
+        position(pos, ss, states);
+    }
+
+    istringstream ss("perft " + depth);
+    go(pos, ss, states);
+    Threads.main()->wait_for_search_finished();
+  }
+
+
+  // selfplay() is called when engine receives the "selfplay" command. It
+  // plays "selfplay [games] [movetime in ms] [result file]" games of the
+  // engine against itself without the game server, e.g. to tune the
+  // lost_pattern and eval_pattern choices. Each side has a game clock of
+  // movetime for each of its moves up to the ply cap. The games are played
+  // one after the other; to use several cores run several processes, each in
+  // a directory of its own, as scripts/datagen.sh does.
+
+  void selfplay(istringstream& is) {
+
+    int games = 1, movetime = 1000;
+    string filename = "result.txt";
+
+    is >> games >> movetime >> filename;
+
+    tcp::selfPlay(games, movetime, filename);
+  }
+
+
+  // tbgen() is called when engine receives the "tbgen" command. It solves
+  // the endgames with up to "tbgen [ghosts] [directory]" ghosts, 5 by
+  // default, and writes the tables to the directory, to be found through
+  // the SyzygyPath option.
+
+  void tbgen(istringstream& is) {
+
+    int ghosts = 5;
+    string path = ".";
+
+    is >> ghosts >> path;
+
+    Tablebases::generate(ghosts, path);
+    Tablebases::init(Options["SyzygyPath"]);
+  }
+
+
+  // bookgen() is called when engine receives the "bookgen" command. It plays
+  // "bookgen [games] [movetime] [searchtime] [plies] [file]" self-play games,
+  // searching the first moves with the longer searchtime, and writes the
+  // opening book of these games to the file, to be used through the
+  // "Book File" option.
+
+  void bookgen(istringstream& is) {
+
+    int games = 1000, movetime = 100, searchtime = 1000, plies = 6;
+    string filename = "book.bin";
+
+    is >> games >> movetime >> searchtime >> plies >> filename;
+
+    Book::generate(games, movetime, searchtime, plies, filename);
+    Book::init(Options["Book File"]);
+  }
+
+
+  // netgen() is called when engine receives the "netgen" command. It writes
+  // "netgen [seed] [file]" a network with random parameters drawn from the
+  // (non zero) seed, to start the training from, or to try the NNUE
+  // evaluation through the "EvalFile" option.
+
+  void netgen(istringstream& is) {
+
+    uint64_t seed = 1;
+    string filename = "geister.nnue";
+
+    is >> seed >> filename;
+
+    Eval::NNUE::generate(seed, filename);
+    Eval::NNUE::init();
+  }
+
+
+  // datagen() is called when engine receives the "datagen" command. It plays
+  // "datagen [games] [nodes] [seed] [file]" self-play games searching every
+  // move for the given nodes, and appends their positions to the file as
+  // training data.
+
+  void datagen(istringstream& is) {
+
+    int games = 100;
+    int64_t nodes = 5000;
+    unsigned seed = 1;
+    string filename = "geister.bin";
+
+    is >> games >> nodes >> seed >> filename;
+
+    Datagen::generate(games, nodes, seed, filename);
+    Book::init(Options["Book File"]);
+  }
+
+
+  // datadump() is called when engine receives the "datadump" command. It
+  // prints the records of the training data file "datadump [file] [count]"
+  // as text, all of them when count is 0.
+
+  void datadump(istringstream& is) {
+
+    uint64_t count = 0;
+    string filename = "geister.bin";
+
+    is >> filename >> count;
+
+    Datagen::dump(filename, count);
+  }
+
+
+  // spsa() is called when engine receives the "spsa" command. It tunes the
+  // parameters registered with TUNE() in "spsa [iterations] [games] [nodes]
+  // [seed]": each iteration plays the games between the parameters shifted
+  // up and down, searching every move for the given nodes. Only a tuning build
+  // (make tune=yes) registers parameters.
+
+  void spsa(istringstream& is) {
+
+    int iterations = 100, games = 8;
+    int64_t nodes = 2000;
+    unsigned seed = 1;
+
+    is >> iterations >> games >> nodes >> seed;
+
+    Book::init("");
+    SPSA::tune(iterations, games, nodes, seed);
+    Book::init(Options["Book File"]);
+  }
+
+
   // bench() is called when engine receives the "bench" command. Firstly
   // a list of UCI commands is setup according to bench parameters, then
   // it is run one by one printing a summary at the end.
@@ -169,7 +346,7 @@ namespace {
   void bench(Position& pos, istream& args, StateListPtr& states) {
 
     string token;
-    uint64_t num, nodes = 0, cnt = 1;
+    uint64_t num, nodes = 0, iterations = 0, evals = 0, cnt = 1;
 
     vector<string> list = setup_bench(pos, args);
     num = count_if(list.begin(), list.end(), [](string s) { return s.find("go ") == 0 || s.find("eval") == 0; });
@@ -181,7 +358,7 @@ namespace {
         istringstream is(cmd);
         is >> skipws >> token;
 
-        if (token == "go" || token == "eval")
+        if (token == "go" || token == "eval" || token == "evals")
         {
             cerr << "\nPosition: " << cnt++ << '/' << num << " (" << pos.fen() << ")" << endl;
             if (token == "go")
@@ -189,11 +366,14 @@ namespace {
                go(pos, is, states);
                Threads.main()->wait_for_search_finished();
                nodes += Threads.nodes_searched();
+               iterations += Threads.iterations_searched();
             }
+            else if (token == "evals")
+               evals += eval_speed(pos, stoi((is >> token, token)));
             else
                trace_eval(pos);
         }
-        else if (token == "setoption")  setoption(is);
+        else if (token == "setoption")  UCI::setoption(is);
         else if (token == "position")   position(pos, is, states);
         else if (token == "ucinewgame") { Search::clear(); elapsed = now(); } // Search::clear() may take some while
     }
@@ -206,6 +386,15 @@ namespace {
          << "\nTotal time (ms) : " << elapsed
          << "\nNodes searched  : " << nodes
          << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+
+    if (evals)
+        cerr << "Evaluations     : " << evals
+             << "\nEvals/second    : " << 1000 * evals / elapsed << endl;
+
+    // Only the ISMCTS backend counts iterations
+    if (iterations)
+        cerr << "Iterations      : " << iterations
+             << "\nIterations/sec  : " << 1000 * iterations / elapsed << endl;
   }
 
   // The win rate model returns the probability (per mille) of winning given an eval
@@ -233,6 +422,31 @@ namespace {
 } // namespace
 
 
+/// UCI::setoption() is called when engine receives the "setoption" UCI command.
+/// The function updates the UCI option ("name") to the given value ("value").
+/// It is also used by main() to set options before the Geister games start.
+
+void UCI::setoption(istream& is) {
+
+  string token, name, value;
+
+  is >> token; // Consume "name" token
+
+  // Read option name (can contain spaces)
+  while (is >> token && token != "value")
+      name += (name.empty() ? "" : " ") + token;
+
+  // Read option value (can contain spaces)
+  while (is >> token)
+      value += (value.empty() ? "" : " ") + token;
+
+  if (Options.count(name))
+      Options[name] = value;
+  else
+      sync_cout << "No such option: " << name << sync_endl;
+}
+
+
 /// UCI::loop() waits for a command from stdin, parses it and calls the appropriate
 /// function. Also intercepts EOF from stdin to ensure gracefully exiting if the
 /// GUI dies unexpectedly. When called with some command line arguments, e.g. to
@@ -261,14 +475,20 @@ void UCI::loop(int argc, char* argv[]) {
 
       if (    token == "quit"
           ||  token == "stop")
+      {
           Threads.stop = true;
+          Threads.main()->wake_up();
+      }
 
       // The GUI sends 'ponderhit' to tell us the user has played the expected move.
       // So 'ponderhit' will be sent if we were told to ponder on the same move the
       // user has played. We should continue searching but switch from pondering to
       // normal search.
       else if (token == "ponderhit")
+      {
           Threads.main()->ponder = false; // Switch to normal search
+          Threads.main()->wake_up();
+      }
 
       else if (token == "uci")
           sync_cout << "id name " << engine_info(true)
@@ -285,6 +505,14 @@ void UCI::loop(int argc, char* argv[]) {
       // Do not use these commands during a search!
       else if (token == "flip")     pos.flip();
       else if (token == "bench")    bench(pos, is, states);
+      else if (token == "perft")    perft(pos, is, states);
+      else if (token == "selfplay") selfplay(is);
+      else if (token == "tbgen")    tbgen(is);
+      else if (token == "bookgen")  bookgen(is);
+      else if (token == "netgen")   netgen(is);
+      else if (token == "datagen")  datagen(is);
+      else if (token == "datadump") datadump(is);
+      else if (token == "spsa")     spsa(is);
       else if (token == "d")        sync_cout << pos << sync_endl;
       else if (token == "eval")     trace_eval(pos);
       else if (token == "compiler") sync_cout << compiler_info() << sync_endl;
@@ -386,63 +614,6 @@ Move UCI::to_move(const Position& pos, string& str) {
 
 
 namespace {
-  bool openPort(int& dstSocket, int port = -1, string dest = "")
-  {
-    // IP AhXC|[gԍC\PbgCsockaddr_in \
-    char destination[32];
-    sockaddr_in dstAddr;
-    int PORT;
-
-    // Windows ̏ꍇ
-    WSADATA data;
-    WSAStartup(MAKEWORD(2, 0), &data);
-
-    // AhX̓͂Ƒ镶̓
-    if (port == -1) {
-      printf("|[gԍ́HF");
-      scanf("%d", &PORT);
-    }
-    else {
-      PORT = port;
-    }
-
-    if (dest.length() == 0) {
-      printf("T[o[}VIṔH:");
-      scanf("%s", destination);
-    }
-    else {
-      for (int i = 0; i < dest.size(); i++) destination[i] = dest[i];
-      destination[dest.size()] = '\0';
-    }
-
-    // sockaddr_in \̂̃Zbg
-    memset(&dstAddr, 0, sizeof(dstAddr));
-    dstAddr.sin_port = htons(PORT);
-    dstAddr.sin_family = AF_INET;
-    //dstAddr.sin_addr.s_addr = inet_addr(destination);
-    assert(inet_pton(dstAddr.sin_family, destination, &dstAddr.sin_addr.S_un.S_addr) == 1);
-
-    // \Pbg̐
-    dstSocket = socket(AF_INET, SOCK_STREAM, 0);
-
-    //ڑ
-    if (connect(dstSocket, (struct sockaddr*)&dstAddr, sizeof(dstAddr)) && WSAGetLastError() != WSAEWOULDBLOCK) {
-      printf("%d\n", WSAGetLastError());
-      printf("%s@ɐڑł܂ł\n", destination);
-      return false;
-    }
-    printf("%s ɐڑ܂\n", destination);
-
-    return true;
-  }
-
-  void closePort(int& dstSocket)
-  {
-    // Windows ł̃\Pbg̏I
-    closesocket(dstSocket);
-    WSACleanup();
-  }
-
   string setInitRedName(int allNum = 0, int redNum = 0, string initRedName = "") {
     if (allNum == 8) return initRedName;
     int ransu = rand() % (8 - allNum);
@@ -454,8 +625,37 @@ namespace {
     }
   }
 
+  // placement() returns the red ghosts for the SET: message, from the book
+  // when it has played placements and at random otherwise.
+  string placement() {
+
+    string reds = Book::placement();
+    return reds.empty() ? setInitRedName() : reds;
+  }
+
+  // GameClock is the time of one side for the whole game. Every move is
+  // charged what it took, so the time that book moves and quick searches
+  // leave unused goes to the later moves. The game is drawn at the ply cap,
+  // so we have at most half of the plies left to play.
+  struct GameClock {
 
-  void go(Position& pos, StateListPtr& states) {
+    TimePoint left;
+    int moves = 0; // Our moves so far
+
+    explicit GameClock(TimePoint time) : left(time) {}
+
+    int moves_to_go() const { return std::max(1, (Referee::MaxPlies + 1) / 2 - moves); }
+
+    void spent(TimePoint used) {
+      left = std::max(TimePoint(1), left - used);
+      moves++;
+    }
+  };
+
+
+  // go() starts the search of our move on the game clock, or for 'movetime'
+  // ms or 'nodes' nodes when they are given.
+  void go(Position& pos, StateListPtr& states, const GameClock& clock, int movetime = 0, int64_t nodes = 0) {
 
     Search::LimitsType limits;
     string token;
@@ -483,7 +683,12 @@ namespace {
       //͓K
 
       //else if (token == "movetime")  is >> limits.movetime;
-      limits.movetime = 1000;
+      limits.movetime = movetime;
+      limits.nodes = nodes;
+      if (!movetime && !nodes) {
+        limits.time[pos.side_to_move()] = clock.left;
+        limits.movestogo = clock.moves_to_go();
+      }
       //else if (token == "mate")      is >> limits.mate;
       limits.mate = VALUE_MATE;  //悭킩
 
@@ -495,20 +700,169 @@ namespace {
       //else if (token == "ponder")    ponderMode = true;
       //pondertrueɂׂȂ̂킩Ȃ
 
+    //ISMCTS: F̉͒T̒Ŗ
+    limits.mcts = Options["Search"] == "ISMCTS";
+
+    //̋̐FŒT𕪂
+    limits.chance = Options["Chance Nodes"];
+
+    //PIMC: ̋̐FS߂Ֆʂ𕡐Tĕς
+    if (!limits.mcts && int(Options["PIMC Samples"]) > 0) {
+      limits.samples = Red::samples(pos, int(Options["PIMC Samples"]));
+    }
+
     Threads.start_thinking(pos, states, limits, ponderMode);
     //pos.print();
   }
 
+  // ponder() starts a background search while the opponent is thinking. The
+  // root is the position after our move 'm' with the opponent to move, so all
+  // of its replies are searched and the positions we will be asked to play
+  // from next are already in the TT when the board message arrives. The
+  // ISMCTS backend does not use the TT, so it does not ponder.
+  void ponder(const Position& pos, Move m) {
+
+    // Nothing to ponder after an escape, which ends the game
+    if (   !Options["Ponder"] || Options["Search"] == "ISMCTS" || m == MOVE_NONE || !MoveList<LEGAL>(pos).contains(m)
+        || type_of(pos.piece_on(to_sq(m))) == GOAL)
+      return;
+
+    StateListPtr states(new std::deque<StateInfo>(1));
+    Position p;
+    p.set(pos.fen(), false, &states->back(), Threads.main());
+    states->emplace_back();
+    p.do_move(m, states->back());
+
+    Search::LimitsType limits;
+    limits.startTime = now();
+    limits.infinite = 1;
+    limits.chance = Options["Chance Nodes"];
+
+    Threads.start_thinking(p, states, limits, true);
+  }
+
+  // stop_pondering() stops a running ponder search and waits for it, so that
+  // the Geister globals (Game_, Red) can be updated for the new position.
+  void stop_pondering() {
+
+    if (Threads.main()->ponder)
+    {
+      Threads.stop = true;
+      Threads.main()->wake_up();
+    }
+
+    Threads.main()->wait_for_search_finished();
+  }
+
+  // setup_turn() sets up the position and the Geister globals (Game_, Red,
+  // Belief) from the board message 'msg' at the start of our turn, and marks
+  // the opponent's ghost that looks most like a red one.
+  void setup_turn(Position& pos, StateListPtr& states, const string& msg) {
+
+    Game_::recvBoard(msg);			//zu
+    states = StateListPtr(new std::deque<StateInfo>(1)); // Drop old and create a new one
+    pos.set(msg, Options["UCI_Chess960"], &states->back(), Threads.main());
+    Red::myTurn(Game_::board, pos);
+    Belief::update(msg, Red::histCnt >= 2 ? Red::hist[Red::histCnt - 2] : nullptr);
+    if (Red::bare)
+      cerr << "oĂ" << endl;
+    cerr << "ԓx" << endl;
+    for (int i = 0; i < 6; i++) {
+      for (int j = 0; j < 6; j++) {
+        cerr << Red::eval[Red::histCnt - 1][i][j] << " ";
+      }
+      cerr << endl;
+    }
+    cerr << "Ԃ̊m";
+    for (int p = 0; p < Belief::PieceNum; p++)
+      cerr << " " << char('a' + p) << ":" << int(100 * Belief::red_prob(p) + 0.5);
+    cerr << endl;
+
+    Square sq_red = Red::picUpRed(Red::redThreshold);
+    //ԓxŌ܂Ȃ, MOŐԂ̊m\
+    if (sq_red == SQ_NONE)
+      sq_red = Belief::likely_red(0.9);
+    //sq_red = SQUARE_ZERO;
+    //sq_red += 1 * EAST;
+    //sq_red += 5 * NORTH;
+    Red::existRed = sq_red != SQ_NONE;
+    if (Red::existRed) {
+      std::cout << Game_::komaName[rank_of(sq_red)][file_of(sq_red)] << " Ԃۂ" << std::endl;
+      pos.piece_change(B_RED, sq_red);
+    }
+  }
+
+  // result_line() is the line written to result.txt for a finished game,
+  // from the end message of the server and the Geister globals of our side.
+  string result_line(const string& recv_msg, const string& initRedName) {
+
+    //Ǐ(Game.h)
+    string s = Game_::getEndInfo(recv_msg);
+    //if (endInfo.find(s) == endInfo.end()) endInfo[s] = 0;
+    //endInfo[s]++;
+    s += (Red::existRed ? " Red" : " Purple");
+    s += " " + initRedName;
+    s += " R.";
+    s += (char)('0' + Game_::rNum);
+    s += " losP.";
+    s += (char)('0' + Game_::lost_pattern);
+    s += " evP.";
+    s += (char)('0' + Game_::eval_pattern);
+    return s;
+  }
+
+  // Side is what one player of a self-play game knows: the Geister globals
+  // that the game loop keeps for the engine, saved while the other side
+  // is to move.
+  struct Side {
+
+    string initRedName;
+    char board[6][6], komaName[6][6];
+    int rNum, uNum, bNum, myrNum, mybNum;
+    int lost_pattern, eval_pattern;
+    int histCnt;
+    char hist[350][6][6];
+    int eval[350][6][6];
+    bool existRed, bare;
+    Belief::State belief;
+
+    void save() {
+      std::memcpy(board, Game_::board, sizeof(board));
+      std::memcpy(komaName, Game_::komaName, sizeof(komaName));
+      rNum = Game_::rNum, uNum = Game_::uNum, bNum = Game_::bNum;
+      myrNum = Game_::myrNum, mybNum = Game_::mybNum;
+      lost_pattern = Game_::lost_pattern, eval_pattern = Game_::eval_pattern;
+      histCnt = Red::histCnt;
+      std::memcpy(hist, Red::hist, histCnt * sizeof(hist[0]));
+      std::memcpy(eval, Red::eval, histCnt * sizeof(eval[0]));
+      existRed = Red::existRed, bare = Red::bare;
+      belief = Belief::state;
+    }
+
+    void load() const {
+      std::memcpy(Game_::board, board, sizeof(board));
+      std::memcpy(Game_::komaName, komaName, sizeof(komaName));
+      Game_::rNum = rNum, Game_::uNum = uNum, Game_::bNum = bNum;
+      Game_::myrNum = myrNum, Game_::mybNum = mybNum;
+      Game_::lost_pattern = lost_pattern, Game_::eval_pattern = eval_pattern;
+      Red::histCnt = histCnt;
+      std::memcpy(Red::hist, hist, histCnt * sizeof(hist[0]));
+      std::memcpy(Red::eval, eval, histCnt * sizeof(eval[0]));
+      Red::existRed = existRed, Red::bare = bare;
+      Belief::state = belief;
+    }
+  };
 
 }//namespace
 
 namespace Game_ {
   char board[6][6];			//board[y][x] = {R:̐, B:̐, u:̋, '.':}X, y=5̑ɂ
   char komaName[6][6];		//komaName[y][x] = {M, (y, x)ɂ̖O}
-  int rNum, uNum, bNum;				//ՖʂɂG̐ԃR}̌, G̃R}̌
+  //O (benchȂ) łg悤ɏzu̒lɂĂ
+  int rNum = 4, uNum = 8, bNum = 4;				//ՖʂɂG̐ԃR}̌, G̃R}̌
   int lost_pattern;
   int eval_pattern;
-  int myrNum, mybNum;
+  int myrNum = 4, mybNum = 4;
 }
 
 //s̐擪t  true
@@ -611,59 +965,22 @@ string Game_:: getEndInfo(string recv_msg) {
 }
 
 
-namespace tcp {
-  int dstSocket;
-}//namespace tcp
-
-void tcp::mySend(int dstSocket, string str = "")
-{
-  if (str.length() == 0) {	//nullȂúv󂯕t
-    cin >> str;
-  }
-  if (str.length() < 2 || str[str.length() - 2] != '\r' || str[str.length() - 1] != '\n') {	//\r\nɂȂΒǉ
-    str += '\r';
-    str += '\n';
-  }
-  int byte = send(dstSocket, str.c_str(), str.length(), 0);	//𑗐M
-  sync_cout << str << sync_endl;
-  if (byte <= 0) {
-    cout << "MG[" << endl;
-  }
-}
-
-string tcp::myRecv(int dstSocket)
-{
-  char buffer[10];
-  string msg;
-
-  do {
-    int byte = recv(dstSocket, buffer, 1, 0);	//M
-
-    if (byte == 0) break;
-    if (byte < 0) { cout << "MɎs܂" << endl; return msg; }
-
-    msg += buffer[0];
-  } while (msg.length() < 2 || msg[msg.length() - 2] != '\r' || msg[msg.length() - 1] != '\n');
-
-  cout << "M = " << msg << endl;
-
-  return msg;
-}
-
 string tcp::MoveStr(Move mv) {
   string ret;
   Square from = from_sq(mv);
   Square to = to_sq(mv);
-  int x = file_of(from) - 1;
-  int y = rank_of(from) - 1;
+  int x = file_of(from);
+  int y = rank_of(from);
+  int dx = file_of(to) - x;
+  int dy = rank_of(to) - y;
 
   ret += "MOV:";
   ret += Game_::komaName[y][x];
   ret += ",";
-  if (from + NORTH == to) ret += 'S';
-  else if (from + EAST == to) ret += 'E';
-  else if (from + WEST == to) ret += 'W';
-  else if (from + SOUTH == to) ret += 'N';
+  if (dx == 0 && dy == 1) ret += 'S';
+  else if (dx == 1 && dy == 0) ret += 'E';
+  else if (dx == -1 && dy == 0) ret += 'W';
+  else if (dx == 0 && dy == -1) ret += 'N';
   else {
     std::cout << file_of(from) << ',' << rank_of(from) << ' ';
     std::cout << file_of(to) << ',' << rank_of(to) << endl;
@@ -674,7 +991,7 @@ string tcp::MoveStr(Move mv) {
 
 
 //UCI::loop ̑ɂȂ悤ɓƎvĂ
-int tcp::playGame(int n, int port = -1, string destination = "") {
+int tcp::playGame(int n, int port, string destination) {
   
   int total = 0;
 
@@ -685,9 +1002,11 @@ int tcp::playGame(int n, int port = -1, string destination = "") {
 
   while (n--) {
 
-    if (!openPort(dstSocket, port, destination)) return 0;
+    //O̎̐ڑcĂΎg
+    if (!tcp::is_open(dstSocket) && !tcp::openPort(dstSocket, port, destination)) return 0;
+    tcp::reset_stats();
     srand((unsigned)time(NULL));
-    string initRedName = setInitRedName();
+    string initRedName = placement();
     tcp::myRecv(dstSocket);							//SET ?̎M
     tcp::mySend(dstSocket, "SET:" + initRedName);	//SET:EFGĤ悤ɓ (, [\r][\n][\0]𖖔ɂđM)
     tcp::myRecv(dstSocket);							//OK, NG̎M
@@ -707,82 +1026,168 @@ int tcp::playGame(int n, int port = -1, string destination = "") {
 
     pos.set(StartFEN, false, &states->back(), Threads.main());
     Red::init();
-    
+    GameClock clock{ TimePoint(int(Options["Game Time"])) };
+
     while (1) {
 
       recv_msg = tcp::myRecv(dstSocket);	//Ֆʂ̎M
+      TimePoint start = now();
+      stop_pondering();
       //recv_msg = StartFEN;
 
       res = Game_::isEnd(recv_msg);
       if (res) break;					//I
 
       //position.cpp recvBoardڐAāAThreadƂ悤ɂH
-      Game_::recvBoard(recv_msg);			//zu
-      states = StateListPtr(new std::deque<StateInfo>(1)); // Drop old and create a new one
-      pos.set(recv_msg, Options["UCI_Chess960"], &states->back(), Threads.main());
-      Red::myTurn(Game_::board, pos);
-      if (Red::bare)
-        cerr << "oĂ" << endl;
-      cerr << "ԓx" << endl;
-      for (int i = 0; i < 6; i++) {
-        for (int j = 0; j < 6; j++) {
-          cerr << Red::eval[Red::histCnt - 1][i][j] << " ";
-        }
-        cerr << endl;
-      }
-      
-      Square sq_red = Red::picUpRed(1000);
-      //sq_red = SQUARE_ZERO;
-      //sq_red += 1 * EAST;
-      //sq_red += 5 * NORTH;
-      if (Red::existRed = (sq_red != SQ_NONE)) {
-        std::cout << Game_::komaName[rank_of(sq_red) - 1][file_of(sq_red) - 1] << " Ԃۂ" << std::endl;
-        pos.piece_change(B_RED, sq_red);
-      }
+      setup_turn(pos, states, recv_msg);
 
       //v
       //string mv = solve(turnCnt);		//vl
-      if (pos.piece_on(SQ_B2) == W_BLUE) {
-        Move mv = make_move(SQ_B2, SQ_B1);
-        Red::myMove(mv);
-        tcp::mySend(tcp::dstSocket, tcp::MoveStr(mv));			//s̑M
-      }
-      else if (pos.piece_on(SQ_G2) == W_BLUE) {
-        Move mv = make_move(SQ_G2, SQ_G1);
-        Red::myMove(mv);
-        tcp::mySend(tcp::dstSocket, tcp::MoveStr(mv));			//s̑M
-      }
-      else
-        go(pos, states);
+      // Escape races are solved by the search before it starts thinking
+      go(pos, states, clock);
+      Threads.main()->wait_for_search_finished();
+      clock.spent(now() - start);
 
       tcp::myRecv(tcp::dstSocket);				//ACK̎M
+
+      //̎Ԃ̊ԂTĂ (Eo͎ŏIǂȂ̂ŕsv)
+      ponder(pos, Threads.main()->bestMove);
       //break;
     }
 
-    //Ǐ(Game.h)
-    string s = Game_::getEndInfo(recv_msg);
-    //if (endInfo.find(s) == endInfo.end()) endInfo[s] = 0;
-    //endInfo[s]++;
-    s += (Red::existRed ? " Red" : " Purple");
-    s += " " + initRedName;
-    s += " R.";
-    s += (char)('0' + Game_::rNum);
-    s += " losP.";
-    s += (char)('0' + Game_::lost_pattern);
-    s += " evP.";
-    s += (char)('0' + Game_::eval_pattern);
-    wfile << s << endl;
-
+    wfile << result_line(recv_msg, initRedName) << endl;
+    cerr << "ʐM " << tcp::stats_str() << endl;
 
-    closePort(dstSocket);
 
     //red::saveGame();
     total += res;
 
-    Sleep(1000);
+    //ڑ̂܂܎̎n܂Ȃg. ؒfĂq
+    if (n > 0) {
+      TimePoint waitStart = now();
+      if (!tcp::wait_message(dstSocket, 1000)) {
+        tcp::closePort(dstSocket);
+        tcp::sleep(int(std::max(TimePoint(0), 1000 - (now() - waitStart))));
+      }
+    }
   }
 
+  if (tcp::is_open(dstSocket))
+    tcp::closePort(dstSocket);
+
   wfile.close();
 
   return total;
 }
+
+
+/// tcp::selfPlay() plays n games of the engine against itself in one process,
+/// without sockets. A Referee::Game keeps the true board; each side is given
+/// the same MOV? board messages as by the game server and goes through the
+/// same steps as in playGame(), with its own copy of the Geister globals.
+/// The first move alternates. Each side has a game clock of 'movetime' ms for
+/// each of its moves up to the ply cap. Both sides' results are written to
+/// 'filename' in the format of result.txt, one line per side and game. The
+/// random placements come from 'seed', or from the clock when it is zero.
+/// The games are sequential, as the sides load their copies into the Game_,
+/// Red and Belief globals of the process in turn; parallel runs take one
+/// process each, as in scripts/datagen.sh.
+
+void tcp::selfPlay(int n, int movetime, string filename, GameObserver* observer, unsigned seed) {
+
+  ofstream wfile(filename, std::ios::out);
+  std::vector<Side> sides(2);
+  int score[3] = {}; // First side: win, loss, draw
+  int64_t totalPlies = 0;
+
+  srand(seed ? seed : (unsigned)time(NULL));
+  TimePoint elapsed = now();
+
+  for (int g = 0; g < n; ++g) {
+
+    Referee::Game game;
+    Referee::Outcome outcome = Referee::NONE;
+    string reason;
+
+    Search::clear();
+
+    for (int p : { 0, 1 }) {
+      sides[p].initRedName = placement();
+      game.set(p, sides[p].initRedName);
+      Game_::lost_pattern = rand() % 2;
+      Game_::eval_pattern = rand() % 2;
+      Red::init();
+      sides[p].save();
+    }
+
+    if (observer)
+        observer->start(sides[0].initRedName, sides[1].initRedName);
+
+    Position pos;
+    StateListPtr states(new deque<StateInfo>(1));
+    std::vector<GameClock> clocks(2, GameClock(TimePoint(movetime) * Referee::MaxPlies / 2));
+    int us = g % 2;
+
+    while (game.ply() < Referee::MaxPlies) {
+
+      TimePoint start = now();
+      if (observer)
+        observer->turn(us);
+      sides[us].load();
+      setup_turn(pos, states, "MOV?" + game.board(us, false));
+
+      go(pos, states, clocks[us], observer ? observer->search_time(pos, us) : 0,
+                                  observer ? observer->search_nodes(pos, us) : 0);
+      Threads.main()->wait_for_search_finished();
+      Move mv = Threads.main()->bestMove;
+      clocks[us].spent(now() - start);
+      if (observer)
+        observer->move(pos, us, mv, Threads.main()->bestPreviousScore, game.board(us, true));
+      Red::myMove(mv);
+      sides[us].save();
+
+      // MOVE_NONE (no legal move) is refused by the referee and loses
+      if (!mv || !game.do_move(us, tcp::MoveStr(mv).substr(4), outcome, reason)) {
+        outcome = Referee::LOSS, reason = "illegal move";
+        break;
+      }
+
+      if (outcome != Referee::NONE)
+        break;
+
+      us = 1 - us;
+    }
+
+    // Winner or -1 for a draw, as seen from the side that moved last
+    int winner =  outcome == Referee::WIN  ? us
+                : outcome == Referee::LOSS ? 1 - us : -1;
+
+    for (int p : { 0, 1 }) {
+      sides[p].load();
+      string end = winner == -1 ? "DRW:" : winner == p ? "WON:" : "LST:";
+      wfile << result_line(end + game.board(p, true), sides[p].initRedName) << endl;
+    }
+
+    if (observer)
+        observer->end(winner);
+
+    score[winner == -1 ? 2 : winner == 0 ? 0 : 1]++;
+    totalPlies += game.ply();
+
+    cerr << "game " << g + 1 << " first " << g % 2 << " "
+         << (winner == -1 ? "draw" : "winner " + std::to_string(winner))
+         << " (" << (winner == -1 ? "ply limit" : reason) << ")" << endl;
+  }
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  cerr << "\n==========================="
+       << "\nGames           : " << n
+       << "\nSide 0 W/L/D    : " << score[0] << "/" << score[1] << "/" << score[2]
+       << "\nTotal time (ms) : " << elapsed
+       << "\nPlies           : " << totalPlies
+       << "\nGames/hour      : " << 3600000 * int64_t(n) / elapsed
+       << "\nms/ply          : " << elapsed / std::max(int64_t(1), totalPlies) << endl;
+
+  wfile.close();
+}
@@ -20,6 +20,7 @@
 #define UCI_H_INCLUDED
 
 
+#include <iosfwd>
 #include <map>
 #include <string>
 
@@ -68,6 +69,7 @@ private:
 
 void init(OptionsMap&);
 void loop(int argc, char* argv[]);
+void setoption(std::istream& is);
 std::string value(Value v);
 std::string square(Square s);
 std::string move(Move m, bool chess960);
@@ -79,15 +81,4 @@ Move to_move(const Position& pos, std::string& str);
 
 extern UCI::OptionsMap Options;
 
-
-namespace tcp {
-  extern int dstSocket;
-
-  void mySend(int dstSocket, std::string str);
-  std::string myRecv(int dstSocket);
-  std::string MoveStr(Move mv);
-
-  int playGame(int n, int port, std::string destination);
-}
-
 #endif // #ifndef UCI_H_INCLUDED
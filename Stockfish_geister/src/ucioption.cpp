@@ -22,6 +22,7 @@
 #include <ostream>
 #include <sstream>
 
+#include "book.h"
 #include "evaluate.h"
 #include "misc.h"
 #include "search.h"
@@ -29,6 +30,7 @@
 #include "tt.h"
 #include "uci.h"
 #include "syzygy/tbprobe.h"
+#include "telemetry.h"
 
 using std::string;
 
@@ -42,8 +44,10 @@ void on_hash_size(const Option& o) { TT.resize(size_t(o)); }
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option& o) { Threads.set(size_t(o)); }
 void on_tb_path(const Option& o) { Tablebases::init(o); }
-//void on_use_NNUE(const Option& ) { Eval::NNUE::init(); }
-//void on_eval_file(const Option& ) { Eval::NNUE::init(); }
+void on_book_file(const Option& o) { Book::init(o); }
+void on_telemetry_file(const Option& o) { Telemetry::init(o); }
+void on_use_NNUE(const Option& ) { Eval::NNUE::init(); }
+void on_eval_file(const Option& ) { Eval::NNUE::init(); }
 
 /// Our case insensitive less() function as required by UCI protocol
 bool CaseInsensitiveLess::operator() (const string& s1, const string& s2) const {
@@ -65,8 +69,13 @@ void init(OptionsMap& o) {
   o["Threads"]               << Option(1, 1, 512, on_threads);
   o["Hash"]                  << Option(16, 1, MaxHashMB, on_hash_size);
   o["Clear Hash"]            << Option(on_clear_hash);
-  o["Ponder"]                << Option(false);
+  o["Ponder"]                << Option(true);
+  o["Game Time"]             << Option(150000, 1000, 3600000);
   o["MultiPV"]               << Option(1, 1, 500);
+  o["PIMC Samples"]          << Option(0, 0, 256);
+  o["Chance Nodes"]          << Option(true);
+  o["Search"]                << Option("AlphaBeta var AlphaBeta var ISMCTS", "AlphaBeta");
+  o["ISMCTS Playout"]        << Option(30, 0, 100);
   o["Skill Level"]           << Option(20, 0, 20);
   o["Move Overhead"]         << Option(10, 0, 5000);
   o["Slow Mover"]            << Option(100, 10, 1000);
@@ -78,10 +87,11 @@ void init(OptionsMap& o) {
   o["UCI_ShowWDL"]           << Option(false);
   o["SyzygyPath"]            << Option("<empty>", on_tb_path);
   o["SyzygyProbeDepth"]      << Option(1, 1, 100);
-  o["Syzygy50MoveRule"]      << Option(true);
   o["SyzygyProbeLimit"]      << Option(7, 0, 7);
-  //o["Use NNUE"]              << Option(true, on_use_NNUE);
-  //o["EvalFile"]              << Option(EvalFileDefaultName, on_eval_file);
+  o["Book File"]             << Option("<empty>", on_book_file);
+  o["Telemetry File"]        << Option("<empty>", on_telemetry_file);
+  o["Use NNUE"]              << Option(false, on_use_NNUE);
+  o["EvalFile"]              << Option("<empty>", on_eval_file);
 }
 
 
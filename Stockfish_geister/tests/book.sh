@@ -0,0 +1,40 @@
+#!/bin/bash
+# verify the opening book: bookgen writes one entry per book position, and
+# the search plays the book move at the start of the games it was built from
+
+error()
+{
+  echo "book testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "book testing started"
+
+./stockfish bookgen 4 20 50 4 book.tmp < /dev/null > /dev/null 2> book.err
+
+positions=`sed -n "s/^Book positions : //p" book.err`
+[ $positions -gt 0 ]
+# header, stats of the 256 red masks and 16 bytes per position
+[ `wc -c < book.tmp` -eq $((8 + 256 * 6 + 16 * positions)) ]
+
+# The starting position of the side to move first for each of the 70
+# placements, some of which were played by bookgen
+echo "setoption name Book File value book.tmp" > book.boards
+for m in `seq 0 255`; do
+  reds=0 board="MOV?"
+  for i in `seq 0 7`; do
+    c=B; [ $((m >> i & 1)) -eq 1 ] && c=R && reds=$((reds + 1))
+    board="$board$((1 + i % 4))$((4 + i / 4))$c"
+  done
+  [ $reds -eq 4 ] && echo "${board}41u31u21u11u40u30u20u10u" >> book.boards
+done
+
+./stockfish bench 16 1 1 book.boards depth < /dev/null > book.out 2>&1
+grep -q "^info string Found $positions book positions$" book.out
+[ `grep -c "^bestmove" book.out` -eq 70 ]
+grep -q "^info string book [a-f][1-6][a-f][1-6] score [0-9]*% of [1-9][0-9]* games$" book.out
+
+rm -f book.tmp book.err book.boards book.out
+
+echo "book testing OK"
@@ -0,0 +1,28 @@
+#!/bin/bash
+# verify the chance nodes: the search must run with and without them, and
+# with them the board with few unknown ghosts left is no longer scored as lost
+
+error()
+{
+  echo "chance testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "chance testing started"
+
+cat << END > chance.boards
+setoption name Chance Nodes value true
+MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+MOV?21B99r99r99r99b22B99b55R45u99r99b33u99r99b12u99b
+setoption name Chance Nodes value false
+MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+END
+
+./stockfish bench 16 1 10 chance.boards depth < /dev/null > chance.out 2>&1
+[ `grep -c "^bestmove" chance.out` -eq 3 ]
+grep "^info depth 10 " chance.out | sed -n 2p | grep -q "score cp [1-9]"
+
+rm -f chance.boards chance.out
+
+echo "chance testing OK"
@@ -0,0 +1,44 @@
+#!/bin/bash
+# verify the training data: datagen writes one 26 bytes record per position
+# played, the same ones for the same seed, and datadump reads them back
+
+error()
+{
+  echo "datagen testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "datagen testing started"
+
+rm -f datagen.bin datagen2.bin
+
+./stockfish datagen 4 2000 7 datagen.bin < /dev/null > /dev/null 2> datagen.err
+
+positions=`sed -n "s/^Positions      : //p" datagen.err`
+[ $positions -gt 0 ]
+[ $positions -eq `sed -n "s/^Plies           : //p" datagen.err` ]
+[ `wc -c < datagen.bin` -eq $((26 * positions)) ]
+grep -q "^Positions/sec  : [0-9]*$" datagen.err
+
+./stockfish datagen 4 2000 7 datagen2.bin < /dev/null > /dev/null 2>&1
+cmp -s datagen.bin datagen2.bin
+
+# 36 squares, score, move, ply, result and player to move, with one
+# position at ply 0 for each game
+./stockfish datadump datagen.bin 0 < /dev/null > datagen.out
+[ `grep -c "^[-BRbr]\{36\} -\?[0-9]* [a-f][1-6][a-f0-9][0-9] [0-9]* -\?[01] [01]$" datagen.out` -eq $positions ]
+[ `awk '$4 == 0' datagen.out | wc -l` -eq 4 ]
+
+# the driver runs one process per seed and appends their files in seed order
+rm -f datagen.bin datagen2.bin
+./stockfish datagen 2 2000 6 datagen.bin < /dev/null > /dev/null 2>&1
+./stockfish datagen 2 2000 7 datagen.bin < /dev/null > /dev/null 2>&1
+bash ../scripts/datagen.sh 2 2 2000 6 datagen2.bin > datagen.out
+cmp -s datagen.bin datagen2.bin
+[ `sed -n "s/^Positions      : //p" datagen.out` -eq $((`wc -c < datagen2.bin` / 26)) ]
+grep -q "^Per process    : [0-9]*$" datagen.out
+
+rm -f datagen.bin datagen2.bin datagen.err datagen.out
+
+echo "datagen testing OK"
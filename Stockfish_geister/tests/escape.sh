@@ -0,0 +1,35 @@
+#!/bin/bash
+# verify the escape solver: forced escapes of both sides are solved before
+# the search, and a race that can be stopped is left to the search
+
+error()
+{
+  echo "escape testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "escape testing started"
+
+cat << END > escape.boards
+MOV?00B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+MOV?35R55R44u23R02u31u41B10B
+MOV?35R55R44u23R01u31u41B10B
+MOV?04u14R34u13u23B33R53u02u42R21B40u
+MOV?35R55R44u23R01u31u10B
+END
+
+./stockfish bench 16 1 6 escape.boards depth < /dev/null > escape.out 2>&1
+
+[ `grep -c "^bestmove" escape.out` -eq 5 ]
+grep -q "^info depth 1 score mate 1 .* pv a1a0$" escape.out
+grep -q "^info depth 3 score mate 2 .* pv b1a1$" escape.out
+grep -q "^info depth 5 score mate 3 .* pv e2e1$" escape.out
+grep -q "^info depth 6 score mate -3 " escape.out
+# a2 captures our last blue on a1, so the last race goes to the search
+[ `grep -c "^info depth [0-9]* score mate" escape.out` -eq 4 ]
+grep -q "^info depth 6 seldepth" escape.out
+
+rm -f escape.boards escape.out
+
+echo "escape testing OK"
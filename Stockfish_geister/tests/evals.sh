@@ -0,0 +1,24 @@
+#!/bin/bash
+# verify the leaf evaluation benchmark: every default position is expanded
+# to its leaves two plies deep, and each leaf is evaluated 'limit' times
+
+error()
+{
+  echo "evals testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "evals testing started"
+
+./stockfish bench 16 1 10 default evals < /dev/null > evals.out 2>&1
+
+[ `grep -c "^info string evals leaves [1-9][0-9]* sum -\?[0-9]*$" evals.out` -eq 17 ]
+leaves=`awk '/^info string evals leaves/ { n += $5 } END { print n }' evals.out`
+[ `sed -n 's/^Evaluations     : //p' evals.out` -eq $((leaves * 10)) ]
+grep -q "^Evals/second    : [1-9]" evals.out
+grep -q "^Nodes searched  : 0$" evals.out
+
+rm -f evals.out
+
+echo "evals testing OK"
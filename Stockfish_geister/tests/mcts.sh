@@ -0,0 +1,44 @@
+#!/bin/bash
+# verify the ISMCTS backend: it must report its iterations, use several
+# threads on the same tree, find an escape of the blue ghosts on the exits and
+# keep the tree within the Hash size
+
+error()
+{
+  echo "mcts testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "mcts testing started"
+
+cat << END > mcts.boards
+setoption name Search value ISMCTS
+MOV?14R24R34R44R15B25B35B45B41u31u21u11u40u30u20u10u
+MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+MOV?00B99r22R99r99b50B13R99r01u99b41u99r33u99r99b99b
+END
+
+for threads in 1 2; do
+   ./stockfish bench 16 $threads 300 mcts.boards movetime < /dev/null > mcts.out 2>&1
+   # the escape of the third board is played by the escape solver
+   grep -c "^info string ismcts iterations [1-9]" mcts.out | grep -q "^2$"
+   grep -q "^Iterations/sec  : [1-9]" mcts.out
+   grep -qE "^bestmove (a1a0|f1f0)" mcts.out
+done
+
+# 100000 iterations with 1 MB for nodes of at least 48 bytes
+cat << END > mcts.boards
+setoption name Search value ISMCTS
+setoption name Hash value 1
+MOV?14R24R34R44R15B25B35B45B41u31u21u11u40u30u20u10u
+END
+
+./stockfish bench 16 1 100 mcts.boards depth < /dev/null > mcts.out 2>&1
+tree=`sed -n "s/^info string ismcts iterations 100[0-9]* .* tree \([0-9]*\) .*/\1/p" mcts.out`
+[ -n "$tree" ] && [ $tree -gt 0 ] && [ $tree -le $((1024 * 1024 / 48)) ]
+grep -q "^bestmove " mcts.out
+
+rm -f mcts.boards mcts.out
+
+echo "mcts testing OK"
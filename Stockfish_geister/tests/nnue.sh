@@ -0,0 +1,42 @@
+#!/bin/bash
+# verify the NNUE evaluation: a generated network is loaded and searched with
+# reproducibly, and a missing one falls back to the classical evaluation
+
+error()
+{
+  echo "nnue testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "nnue testing started"
+
+rm -f nnue.boards nnue.out nnue.nnue
+
+./stockfish netgen 7 nnue.nnue < /dev/null > nnue.out 2>&1
+grep -q "^Network file   : nnue.nnue$" nnue.out
+[ -s nnue.nnue ]
+
+cat << END > nnue.boards
+setoption name EvalFile value nnue.nnue
+setoption name Use NNUE value true
+MOV?15B25B35B45B14R24R34R44R11u21u31u41u10u20u30u40u
+MOV?14B24B34B44B15B25B35B45B41u31u21u11u40u30u20u10u
+END
+
+./stockfish bench 16 1 8 nnue.boards depth < /dev/null > nnue.out 2>&1
+grep -q "^info string NNUE evaluation using nnue.nnue enabled$" nnue.out
+nodes=`sed -n 's/^Nodes searched  : //p' nnue.out`
+./stockfish bench 16 1 8 nnue.boards depth < /dev/null 2>&1 | grep -q "^Nodes searched  : $nodes$"
+
+# a network that cannot be read leaves the classical evaluation in place
+sed -i 's/value nnue.nnue/value missing.nnue/' nnue.boards
+./stockfish bench 16 1 8 nnue.boards depth < /dev/null > nnue.out 2>&1
+grep -q "^info string Could not load NNUE network missing.nnue, classical evaluation enabled$" nnue.out
+nodes=`sed -n 's/^Nodes searched  : //p' nnue.out`
+sed -i '/^setoption/d' nnue.boards
+./stockfish bench 16 1 8 nnue.boards depth < /dev/null 2>&1 | grep -q "^Nodes searched  : $nodes$"
+
+rm -f nnue.boards nnue.out nnue.nnue
+
+echo "nnue testing OK"
@@ -1,5 +1,5 @@
 #!/bin/bash
-# verify perft numbers (positions from www.chessprogramming.org/Perft_Results)
+# verify perft numbers of Geister boards (MOV? strings as sent by the game server)
 
 error()
 {
@@ -10,23 +10,20 @@ trap 'error ${LINENO}' ERR
 
 echo "perft testing started"
 
-cat << EOF > perft.exp
-   set timeout 10
-   lassign \$argv pos depth result
-   spawn ./stockfish
-   send "position \$pos\\ngo perft \$depth\\n"
-   expect "Nodes searched? \$result" {} timeout {exit 1}
-   send "quit\\n"
-   expect eof
-EOF
-
-expect perft.exp startpos 5 4865609 > /dev/null
-expect perft.exp "fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -" 5 193690690 > /dev/null
-expect perft.exp "fen 8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -" 6 11030083 > /dev/null
-expect perft.exp "fen r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" 5 15833292 > /dev/null
-expect perft.exp "fen rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" 5 89941194 > /dev/null
-expect perft.exp "fen r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" 5 164075551 > /dev/null
+perft()
+{
+  ./stockfish perft $2 "$1" < /dev/null | grep -q "^Nodes searched: $3$"
+}
 
-rm perft.exp
+# initial setup, both sides on their back two rows
+perft "MOV?14R24R34R44R15B25B35B45B41u31u21u11u40u30u20u10u" 8 308483982
+# middle game, white and black to move
+perft "MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u" 7 443323790
+perft "MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u b" 7 430875619
+# blue pieces next to the exits, escapes and captures of the goals
+perft "MOV?00B99r22R99r99b50B13R99r01u99b41u99r33u99r99b99b" 8 256700285
+perft "MOV?10B35R99r99r99b41B23R55R44u99r02u99b31u99r99b99b" 8 626772174
+# few pieces left
+perft "MOV?10B99r99r99r99b22B99b55R45u99r99b33u99r99b14u99b" 8 64415849
 
 echo "perft testing OK"
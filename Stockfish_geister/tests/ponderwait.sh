@@ -0,0 +1,30 @@
+#!/bin/bash
+# verify that a finished infinite or ponder search waits for "stop" or
+# "ponderhit" without using the CPU: 2 seconds of waiting must cost well
+# under a second of CPU time (a busy wait costs about 2 seconds)
+
+error()
+{
+  echo "ponderwait testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "ponderwait testing started"
+
+TIMEFORMAT="%U %S"
+
+{ time ( (echo "go infinite depth 1"; sleep 2; echo "stop"; echo "quit") \
+         | ./stockfish uci > ponderwait.out ) ; } 2> ponderwait.time
+grep -q "^bestmove" ponderwait.out
+echo "CPU seconds (user sys) of a 2 second wait: `cat ponderwait.time`"
+[ `awk '{ print int(($1 + $2) * 1000) }' ponderwait.time` -lt 500 ]
+
+# ponderhit turns the waiting ponder search into a normal one, which ends
+(echo "go ponder depth 1"; sleep 1; echo "ponderhit"; sleep 1; echo "quit") \
+  | ./stockfish uci > ponderwait.out
+grep -q "^bestmove" ponderwait.out
+
+rm -f ponderwait.out ponderwait.time
+
+echo "ponderwait testing OK"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# verify in-process self-play: every game gives one line per side in the
+# result.txt format, a win on one side matching a loss on the other
+
+error()
+{
+  echo "selfplay testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "selfplay testing started"
+
+./stockfish selfplay 4 20 selfplay.txt > /dev/null 2> selfplay.err
+
+grep -q "^Games           : 4$" selfplay.err
+[ `wc -l < selfplay.txt` -eq 8 ]
+[ `grep -c "^won\|^lost\|^draw" selfplay.txt` -eq 8 ]
+[ `grep -c "^won" selfplay.txt` -eq `grep -c "^lost" selfplay.txt` ]
+
+rm -f selfplay.txt selfplay.err
+
+echo "selfplay testing OK"
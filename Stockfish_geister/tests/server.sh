@@ -0,0 +1,68 @@
+#!/bin/bash
+# verify the local game server with two scripted clients: player 0 walks its
+# blue ghost E to the exit at (0,0) and escapes while player 1 shuffles
+
+error()
+{
+  echo "server testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "server testing started"
+
+port=${1:-10300}
+
+./geister_server 1 $port > server.out 2> server.err &
+
+for i in `seq 50`; do
+   if grep -q "geister_server:" server.err; then break; fi
+   sleep 0.1
+done
+
+exec 3<>/dev/tcp/127.0.0.1/$port
+exec 4<>/dev/tcp/127.0.0.1/$((port + 1))
+
+expect_line()
+{
+  read -r line <&$1
+  line=${line%$'\r'}
+  [[ "$line" == $2 ]]
+}
+
+send_line()
+{
+  printf '%s\r\n' "$2" >&$1
+}
+
+expect_line 3 "SET?";  send_line 3 "SET:ABCD";  expect_line 3 "OK"
+expect_line 4 "SET?";  send_line 4 "SET:ABCD";  expect_line 4 "OK"
+
+moves0=(E,W E,N E,N E,N E,N E,N E,N)
+moves1=(E,W E,E E,W E,E E,W E,E)
+
+for i in `seq 0 6`; do
+   if [ $i -eq 0 ]; then
+      expect_line 3 "MOV?14R24R34R44R15B25B35B45B41u31u21u11u40u30u20u10u"
+   else
+      expect_line 3 "MOV?*"
+   fi
+   send_line 3 "MOV:${moves0[$i]}"
+   expect_line 3 "ACK"
+   if [ $i -lt 6 ]; then
+      expect_line 4 "MOV?*"
+      send_line 4 "MOV:${moves1[$i]}"
+      expect_line 4 "ACK"
+   fi
+done
+
+expect_line 3 "WON:*88b*"
+expect_line 4 "LST:*"
+
+wait
+grep -q "game 1 first 0 winner 0 (escaped)" server.out
+grep -q "Plies           : 13" server.out
+grep -c "connected" server.err | grep -q "^2$"
+rm -f server.out server.err
+
+echo "server testing OK"
@@ -0,0 +1,33 @@
+#!/bin/bash
+# report nodes per second scaling of the Lazy SMP search from 1 to N threads
+# usage: smp.sh [max threads] [movetime in ms]
+
+error()
+{
+  echo "smp scaling run failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+maxthreads=${1:-`nproc`}
+movetime=${2:-5000}
+
+echo "smp scaling started (1 to $maxthreads threads, $movetime ms each)"
+
+base=0
+threads=1
+while [ $threads -le $maxthreads ]; do
+   nps=`./stockfish bench 64 $threads $movetime current movetime 2>&1 | grep "Nodes/second    : " | awk '{print $3}'`
+   if [ $base -eq 0 ]; then
+      base=$nps
+   fi
+   speedup=`awk -v a=$nps -v b=$base 'BEGIN { printf "%.2f", a / b }'`
+   echo "threads $threads nps $nps speedup $speedup"
+   if [ $threads -lt $maxthreads ] && [ $((threads * 2)) -gt $maxthreads ]; then
+      threads=$maxthreads
+   else
+      threads=$((threads * 2))
+   fi
+done
+
+echo "smp scaling OK"
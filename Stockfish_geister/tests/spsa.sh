@@ -0,0 +1,45 @@
+#!/bin/bash
+# verify the tuning: a normal build registers no parameters, while in a tuning
+# build (make tune=yes) the Geister weights are UCI options that the evaluation
+# reads, and spsa iterates them reproducibly within their ranges
+
+error()
+{
+  echo "spsa testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "spsa testing started"
+
+if ! echo uci | ./stockfish uci | grep -q "^option name ExistWeight "; then
+  # no Fishtest lines at startup and nothing to tune
+  [ -z "`./stockfish quit < /dev/null | grep ","`" ]
+  ./stockfish spsa 3 2 500 5 < /dev/null 2>&1 | grep -q "^No parameters to tune"
+  echo "spsa testing OK (not a tuning build)"
+  exit 0
+fi
+
+cat << END > spsa.boards
+MOV?15B25B35B45B14R24R34R44R11u21u31u41u10u20u30u40u
+MOV?14B24B34B44B15B25B35B45B41u31u21u11u40u30u20u10u
+END
+
+nodes=`./stockfish bench 16 1 8 spsa.boards depth < /dev/null 2>&1 | sed -n 's/^Nodes searched  : //p'`
+sed -i '1i setoption name DistWeight value 3' spsa.boards
+./stockfish bench 16 1 8 spsa.boards depth < /dev/null 2>&1 | grep "^Nodes searched  : " > spsa.out
+! grep -q " $nodes$" spsa.out
+
+./stockfish spsa 3 2 500 5 < /dev/null 2>&1 > /dev/null | grep -v "^game " > spsa.out
+[ `grep -c "^iteration [1-3] score -\?[0-2] ExistWeight" spsa.out` -eq 3 ]
+grep -q "^Games           : 6$" spsa.out
+[ `tail -6 spsa.out | grep -c "^[A-Za-z:]*,[0-9]*$"` -eq 6 ]
+[ `tail -6 spsa.out | awk -F, '$1 == "ExistWeight" && $2 >= 500 && $2 <= 2000'` ]
+
+./stockfish spsa 3 2 500 5 < /dev/null 2>&1 > /dev/null | grep -v "^game " > spsa2.out
+# the same games and values, all but the timings
+[ "`grep -v "^Total time\|^Games/hour\|^ms/ply" spsa.out`" = "`grep -v "^Total time\|^Games/hour\|^ms/ply" spsa2.out`" ]
+
+rm -f spsa.boards spsa.out spsa2.out
+
+echo "spsa testing OK"
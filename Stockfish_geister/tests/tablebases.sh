@@ -0,0 +1,33 @@
+#!/bin/bash
+# verify the Geister tablebases: generate the 4 ghost table, check its size
+# and that every result is resolved, and that the search probes it and plays
+# the capture of the last blue
+
+error()
+{
+  echo "tablebases testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "tablebases testing started"
+
+rm -rf tb.tmp && mkdir tb.tmp
+
+./stockfish tbgen 4 tb.tmp < /dev/null > tbgen.out 2>&1
+grep -q "^info string tbgen BRvBR positions 1679616 .* unresolved 0 " tbgen.out
+[ `wc -c < tb.tmp/BRvBR.gtb` -eq 1679632 ]
+
+cat << END > tb.boards
+setoption name SyzygyPath value tb.tmp
+MOV?21B55R45b33r
+END
+
+./stockfish bench 16 1 8 tb.boards depth < /dev/null > tb.out 2>&1
+grep -q "^info string Found 1 tablebases" tb.out
+grep -q "tbhits [1-9]" tb.out
+grep -q "^bestmove f6e6" tb.out
+
+rm -rf tb.tmp tb.boards tb.out tbgen.out
+
+echo "tablebases testing OK"
@@ -0,0 +1,36 @@
+#!/bin/bash
+# verify the telemetry stream: one JSON line per searched move, with the
+# fields of the search
+
+error()
+{
+  echo "telemetry testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "telemetry testing started"
+
+rm -f telemetry.jsonl
+
+cat << END > telemetry.boards
+setoption name Telemetry File value telemetry.jsonl
+MOV?14B24B34B44B15B25B35B45B41u31u21u11u40u30u20u10u
+MOV?00B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+MOV?14B24B34B44B15B25B35B45B41u31u21u11u40u30u20u10u
+END
+
+./stockfish bench 16 1 8 telemetry.boards depth < /dev/null > telemetry.out 2>&1
+
+[ `wc -l < telemetry.jsonl` -eq 3 ]
+[ `grep -c '^{"turn":[0-9]*,"backend":"[a-z]*","depth":[0-9]*,"seldepth":[0-9]*,"score":-\?[0-9]*,"nodes":[0-9]*,"nps":[0-9]*,"tthit":[0-9.e-]*,"hashfull":[0-9]*,"time":[0-9]*,"allotted":[0-9]*,"maximum":[0-9]*,"bestmove":"[a-f0-9]*","pv":\["[a-f0-9]*"[^]]*\],"red":\[\("[a-f][1-6]",\?\)*\],"belief":\[[0-9.e,-]*\]}$' telemetry.jsonl` -eq 3 ]
+# the escape is played by the solver, the other moves by the alpha-beta search
+[ "`sed -n 's/.*"backend":"\([a-z]*\)".*/\1/p' telemetry.jsonl`" = "alphabeta
+escape
+alphabeta" ]
+# the best move of the record is the one sent to the GUI
+[ "`sed -n 's/.*"bestmove":"\([^"]*\)".*/\1/p' telemetry.jsonl`" = "`sed -n 's/^bestmove \([^ ]*\).*/\1/p' telemetry.out`" ]
+
+rm -f telemetry.boards telemetry.out telemetry.jsonl
+
+echo "telemetry testing OK"
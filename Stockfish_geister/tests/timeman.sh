@@ -0,0 +1,27 @@
+#!/bin/bash
+# verify the game clock: with a blue on an exit the escape is played at
+# once, and a search on the clock stays within its budget
+
+error()
+{
+  echo "timeman testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "timeman testing started"
+
+cat << END > timeman.boards
+MOV?00B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+MOV?04B24B35B99r15B01R32R99r54u99r12u99r43u30u20u10u
+END
+
+./stockfish bench 16 1 10000 timeman.boards wtime < /dev/null > timeman.out 2>&1
+[ `grep -c "^bestmove" timeman.out` -eq 2 ]
+grep -B2 "^bestmove a1a0" timeman.out | grep -q "^info depth .* time [0-9] "
+# 80% of the clock at most, for both moves together
+[ `sed -n "s/^Total time (ms) : //p" timeman.out` -lt 8000 ]
+
+rm -f timeman.boards timeman.out
+
+echo "timeman testing OK"